@@ -0,0 +1,78 @@
+#include "appconfig.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSettings>
+
+QString AppConfig::defaultPath()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath("dldl-lhsj.ini");
+}
+
+AppConfig AppConfig::load(const QString &path)
+{
+    AppConfig c;
+    QSettings s(path, QSettings::IniFormat);
+
+    s.beginGroup("template");
+    c.scaleMax = s.value("scaleMax", c.scaleMax).toDouble();
+    c.scaleMin = s.value("scaleMin", c.scaleMin).toDouble();
+    c.scaleStep = s.value("scaleStep", c.scaleStep).toDouble();
+    c.featureType = s.value("featureType", c.featureType).toString();
+    c.featureMinInliers = s.value("featureMinInliers", c.featureMinInliers).toInt();
+    c.templateTracking = s.value("tracking", c.templateTracking).toBool();
+    c.trackMinScore = s.value("trackMinScore", c.trackMinScore).toDouble();
+    c.trackMargin = s.value("trackMargin", c.trackMargin).toInt();
+    c.goodEnoughScore = s.value("goodEnoughScore", c.goodEnoughScore).toDouble();
+    c.matchThreads = s.value("threads", c.matchThreads).toInt();
+    s.endGroup();
+
+    s.beginGroup("ocr");
+    c.ocrRoiEnabled = s.value("roiEnabled", c.ocrRoiEnabled).toBool();
+    c.ocrRoiMargin = s.value("roiMargin", c.ocrRoiMargin).toDouble();
+    c.ocrRoiMinPad = s.value("roiMinPad", c.ocrRoiMinPad).toInt();
+    c.ocrRoiMinScore = s.value("roiMinTemplateScore", c.ocrRoiMinScore).toDouble();
+    // ini 中以逗号分隔
+    c.ocrKeywords = s.value("keywords", c.ocrKeywords).toStringList();
+    c.ocrKeywords.removeAll(QString());
+    if (c.ocrKeywords.isEmpty()) c.ocrKeywords = AppConfig().ocrKeywords;
+    c.ocrCascadeMode = s.value("cascadeMode", c.ocrCascadeMode).toString();
+    c.ocrCascadeMinConfidence = s.value("cascadeMinConfidence", c.ocrCascadeMinConfidence).toDouble();
+    c.ocrLineMode = s.value("lineMode", c.ocrLineMode).toBool();
+    c.ocrLineHeight = s.value("lineHeight", c.ocrLineHeight).toInt();
+    c.ocrLineMaxRegions = s.value("lineMaxRegions", c.ocrLineMaxRegions).toInt();
+    s.endGroup();
+
+    s.beginGroup("cache");
+    c.resultCacheEnabled = s.value("enabled", c.resultCacheEnabled).toBool();
+    c.resultCacheCapacity = s.value("capacity", c.resultCacheCapacity).toInt();
+    c.resultCacheTolerance = s.value("tolerance", c.resultCacheTolerance).toInt();
+    s.endGroup();
+
+    s.beginGroup("capture");
+    c.captureWindow = s.value("window", c.captureWindow).toString();
+    c.captureBuffers = s.value("buffers", c.captureBuffers).toInt();
+    s.endGroup();
+
+    s.beginGroup("pipeline");
+    c.pipelineFps = s.value("fps", c.pipelineFps).toDouble();
+    c.pipelineGating = s.value("gating", c.pipelineGating).toBool();
+    c.pipelineMinChangedTiles = s.value("minChangedTiles", c.pipelineMinChangedTiles).toInt();
+    c.pipelineFrameDir = s.value("frameDir", c.pipelineFrameDir).toString();
+    c.pipelineLoop = s.value("loop", c.pipelineLoop).toBool();
+    c.pipelineIncremental = s.value("incremental", c.pipelineIncremental).toBool();
+    c.pipelineIncrementalFullRatio = s.value("incrementalFullRatio", c.pipelineIncrementalFullRatio).toDouble();
+    s.endGroup();
+
+    s.beginGroup("log");
+    c.logLevel = s.value("level", c.logLevel).toString();
+    c.logUiIntervalMs = s.value("uiIntervalMs", c.logUiIntervalMs).toInt();
+    c.logUiMaxLines = s.value("uiMaxLines", c.logUiMaxLines).toInt();
+    s.endGroup();
+
+    s.beginGroup("metrics");
+    c.metricsDumpPath = s.value("dumpPath", c.metricsDumpPath).toString();
+    s.endGroup();
+
+    return c;
+}
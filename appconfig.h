@@ -0,0 +1,75 @@
+#ifndef APPCONFIG_H
+#define APPCONFIG_H
+
+#include <QString>
+#include <QStringList>
+
+// 运行参数，启动时从程序目录的 dldl-lhsj.ini 读取，缺省值即原有行为
+struct AppConfig
+{
+    // 模板匹配：尺度从 scaleMax 按 scaleStep 递减到 scaleMin
+    double scaleMax = 1.0;
+    double scaleMin = 0.4;
+    double scaleStep = 0.1;
+    // 特征点匹配模式：orb / akaze，RANSAC 内点数下限
+    QString featureType = QStringLiteral("orb");
+    int featureMinInliers = 8;
+    // 连续识别时跟踪上次命中：只在其附近窗口、相邻尺度匹配，得分低于 trackMinScore 时回退全图
+    bool templateTracking = true;
+    double trackMinScore = 0.8;
+    int trackMargin = 32;
+    // 某一尺度得分达到该值即取消后续尺度，<=0 表示关闭
+    double goodEnoughScore = 0.0;
+    // 并行匹配尺度的线程数，0 表示使用 CPU 核数
+    int matchThreads = 0;
+
+    // OCR 区域模式：已知标签位置时只识别其周围区域，未命中再全图识别。
+    // 没有上次命中时需等模板匹配给出位置，OCR 不再与模板匹配并行，故默认关闭
+    bool ocrRoiEnabled = false;
+    double ocrRoiMargin = 0.5;      // 每边按标签宽高的比例外扩
+    int ocrRoiMinPad = 16;          // 每边至少外扩的像素
+    double ocrRoiMinScore = 0.8;    // 模板得分达到该值才用作 ROI
+    // 一次识别中同时查找的关键词（不含空白），第一项为主标签，用于定位与 ROI
+    QStringList ocrKeywords = { QStringLiteral("魂兽幻境") };
+    // fast / accuracy 调度：parallel 同时识别，cascade 先 fast 未采纳再 accuracy，
+    // speculative 同时启动、fast 被采纳后取消 accuracy；缺省 parallel 即原有行为
+    QString ocrCascadeMode = QStringLiteral("parallel");
+    double ocrCascadeMinConfidence = 60.0;  // 主关键词置信度达到该值即采纳 fast 结果
+    // 整图识别时先检测候选文本行，各行放大二值化后按单行并行识别，代替整页版面分析；
+    // 候选行超过 ocrLineMaxRegions 时仍走整页识别
+    bool ocrLineMode = false;
+    int ocrLineHeight = 32;         // 行高不足时放大到该高度
+    int ocrLineMaxRegions = 48;
+
+    // 识别结果缓存：按画面差分哈希复用见过的画面的结果；tolerance 为允许的汉明距离（共 256 位）。
+    // 相近画面可能只差一两位，默认关闭，开启时也只接受完全相同的哈希
+    bool resultCacheEnabled = false;
+    int resultCacheCapacity = 64;
+    int resultCacheTolerance = 0;
+
+    // 截图：X11 下截取的窗口 id（如 0x3a00007），为空时截取整个屏幕；缓冲环大小
+    QString captureWindow;
+    int captureBuffers = 3;
+
+    // 连续识别管线
+    double pipelineFps = 5.0;
+    bool pipelineGating = true;     // 画面无变化时跳过识别
+    int pipelineMinChangedTiles = 1;
+    QString pipelineFrameDir;       // 帧目录（PNG）或录制的视频，未选窗口时使用；视频或带 timestamps.txt 的目录按原速回放
+    bool pipelineLoop = false;
+    bool pipelineIncremental = true;        // 只重新识别画面变化的格子，其余沿用上次结果
+    double pipelineIncrementalFullRatio = 0.5;  // 变化面积超过该比例时整图识别
+
+    // 日志：级别 debug / info / warning / error；界面日志最多每 logUiIntervalMs 刷新一次
+    QString logLevel = QStringLiteral("info");
+    int logUiIntervalMs = 100;
+    int logUiMaxLines = 5000;
+
+    // 分阶段耗时：非空时退出前写入该文件（.prom / .txt 为 Prometheus 文本，否则 JSON）
+    QString metricsDumpPath;
+
+    static QString defaultPath();
+    static AppConfig load(const QString &path = defaultPath());
+};
+
+#endif // APPCONFIG_H
@@ -0,0 +1,455 @@
+// 识别热点微基准：截图、模板匹配、图像转换、Tesseract Init / Recognize、预览渲染
+// 每个用例报告延迟分位数（min/p50/p90/p99/max/mean）与每次调用的堆分配次数和字节数，
+// 结果以 CSV 打印到标准输出，并可写成 JSON 供不同提交之间对比。
+//
+// 用法: bench_detect [--iters N] [--heavy-iters N] [--fixtures dir] [--filter 子串]
+//                    [--json out.json] [--label 提交号] [--baseline 旧结果.json]
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+#include <tesseract/baseapi.h>
+#include <leptonica/allheaders.h>
+
+#include "capturesource.h"
+#include "detector.h"
+#include "frame.h"
+#include "imageconvert.h"
+#include "markrender.h"
+#include "resultcache.h"
+#include "templatetracker.h"
+#include "textregions.h"
+
+// ---- 分配计数 ----
+// glibc 下替换 malloc 系列，可同时统计 Qt / OpenCV / Leptonica 的 C 分配；
+// 其他平台只替换 operator new，统计的是 C++ 堆分配。
+namespace {
+std::atomic<quint64> g_allocCount{0};
+std::atomic<quint64> g_allocBytes{0};
+inline void countAlloc(std::size_t n)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+}
+} // namespace
+
+#if defined(__GLIBC__)
+static const char *kAllocSource = "malloc";
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+void __libc_free(void *);
+
+void *malloc(size_t n) noexcept { countAlloc(n); return __libc_malloc(n); }
+void *calloc(size_t c, size_t n) noexcept { countAlloc(c * n); return __libc_calloc(c, n); }
+void *realloc(void *p, size_t n) noexcept { countAlloc(n); return __libc_realloc(p, n); }
+void free(void *p) noexcept { __libc_free(p); }
+int posix_memalign(void **out, size_t align, size_t n) noexcept
+{
+    countAlloc(n);
+    void *p = __libc_memalign(align, n);
+    if (!p) return ENOMEM;
+    *out = p;
+    return 0;
+}
+void *aligned_alloc(size_t align, size_t n) noexcept { countAlloc(n); return __libc_memalign(align, n); }
+void *memalign(size_t align, size_t n) noexcept { countAlloc(n); return __libc_memalign(align, n); }
+}
+#else
+static const char *kAllocSource = "operator_new";
+void *operator new(std::size_t n)
+{
+    countAlloc(n);
+    if (void *p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void *operator new[](std::size_t n) { return ::operator new(n); }
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+#endif
+
+namespace {
+
+struct CaseResult {
+    QString name;
+    QString fixture;
+    int iters = 0;
+    double minMs = 0, p50Ms = 0, p90Ms = 0, p99Ms = 0, maxMs = 0, meanMs = 0;
+    double allocsPerCall = 0;
+    double allocBytesPerCall = 0;
+};
+
+double percentile(const std::vector<double> &sorted, double q)
+{
+    // 最近秩法
+    const size_t rank = (size_t)std::ceil(q * sorted.size());
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+CaseResult measure(const QString &name, const QString &fixture, int iters, const std::function<void()> &fn)
+{
+    fn(); // 预热：首次调用的缓存构建不计入
+    std::vector<double> samples;
+    samples.reserve(iters);
+    const quint64 allocs0 = g_allocCount.load();
+    const quint64 bytes0 = g_allocBytes.load();
+    for (int i = 0; i < iters; ++i) {
+        QElapsedTimer t; t.start();
+        fn();
+        samples.push_back(t.nsecsElapsed() / 1e6);
+    }
+    const quint64 allocs = g_allocCount.load() - allocs0;
+    const quint64 bytes = g_allocBytes.load() - bytes0;
+
+    CaseResult r;
+    r.name = name;
+    r.fixture = fixture;
+    r.iters = iters;
+    double sum = 0;
+    for (double s : samples) sum += s;
+    std::sort(samples.begin(), samples.end());
+    r.minMs = samples.front();
+    r.maxMs = samples.back();
+    r.p50Ms = percentile(samples, 0.50);
+    r.p90Ms = percentile(samples, 0.90);
+    r.p99Ms = percentile(samples, 0.99);
+    r.meanMs = sum / iters;
+    r.allocsPerCall = double(allocs) / iters;
+    r.allocBytesPerCall = double(bytes) / iters;
+    return r;
+}
+
+struct Fixture {
+    QString name;
+    QImage image;
+};
+
+// 合成固定截图：固定种子的色块背景，按 0.7 倍把模板贴在固定相对位置
+QImage makeFixture(const QSize &size, const QImage &tmpl)
+{
+    QImage img(size, QImage::Format_ARGB32);
+    img.fill(QColor(38, 42, 56));
+    QPainter p(&img);
+    quint32 seed = 12345;
+    auto next = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+    for (int i = 0; i < 400; ++i) {
+        const int w = 8 + int(next() % 160), h = 8 + int(next() % 90);
+        p.fillRect(int(next() % size.width()), int(next() % size.height()), w, h,
+                   QColor::fromRgb(0xff000000u | next()));
+    }
+    if (!tmpl.isNull()) {
+        const QImage t = tmpl.scaled(tmpl.size() * 0.7, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        p.drawImage(QPoint(size.width() * 3 / 5, size.height() / 4), t);
+    }
+    p.end();
+    return img;
+}
+
+QList<Fixture> loadFixtures(const QString &dir, const QImage &tmpl)
+{
+    QList<Fixture> out;
+    if (!dir.isEmpty()) {
+        QDir d(dir);
+        for (const QString &f : d.entryList(QStringList() << "*.png", QDir::Files, QDir::Name)) {
+            QImage img(d.filePath(f));
+            if (img.isNull()) continue;
+            out << Fixture{ QFileInfo(f).completeBaseName(), img.convertToFormat(QImage::Format_ARGB32) };
+        }
+        return out;
+    }
+    const QSize sizes[] = { QSize(1280, 720), QSize(1920, 1080), QSize(2560, 1440) };
+    for (const QSize &sz : sizes)
+        out << Fixture{ QString("%1x%2").arg(sz.width()).arg(sz.height()), makeFixture(sz, tmpl) };
+    return out;
+}
+
+// 旧实现：逐像素写 Pix（对比基线）
+Pix *legacyGrayPix(const QImage &shot)
+{
+    QImage gray = shot.convertToFormat(QImage::Format_Grayscale8);
+    Pix *pix = pixCreate(gray.width(), gray.height(), 8);
+    for (int y = 0; y < gray.height(); ++y) {
+        const uchar *line = gray.constScanLine(y);
+        for (int x = 0; x < gray.width(); ++x) {
+            pixSetPixel(pix, x, y, line[x]);
+        }
+    }
+    return pix;
+}
+
+// 旧实现：qimageToMat 的 RGBA 拷贝 + 转换（对比基线）
+cv::Mat legacyBgr(const QImage &shot)
+{
+    QImage swapped = shot.convertToFormat(QImage::Format_RGBA8888);
+    cv::Mat rgba = cv::Mat(swapped.height(), swapped.width(), CV_8UC4,
+                           const_cast<uchar*>(swapped.bits()), swapped.bytesPerLine()).clone();
+    cv::Mat bgr; cv::cvtColor(rgba, bgr, cv::COLOR_RGBA2BGR);
+    return bgr;
+}
+
+QJsonObject toJson(const CaseResult &r)
+{
+    return QJsonObject{
+        {"name", r.name}, {"fixture", r.fixture}, {"iters", r.iters},
+        {"min_ms", r.minMs}, {"p50_ms", r.p50Ms}, {"p90_ms", r.p90Ms}, {"p99_ms", r.p99Ms},
+        {"max_ms", r.maxMs}, {"mean_ms", r.meanMs},
+        {"allocs_per_call", r.allocsPerCall}, {"alloc_bytes_per_call", r.allocBytesPerCall}
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("识别热点微基准");
+    parser.addHelpOption();
+    QCommandLineOption itersOpt("iters", "轻量用例的迭代次数", "n", "50");
+    QCommandLineOption heavyOpt("heavy-iters", "Init / Recognize / 模板匹配的迭代次数", "n", "5");
+    QCommandLineOption fixturesOpt("fixtures", "使用目录中的 PNG 截图代替合成截图", "dir");
+    QCommandLineOption tessdataOpt("tessdata", "tessdata 目录", "dir", QStringLiteral(DLDL_SOURCE_DIR "/tessdata"));
+    QCommandLineOption langOpt("lang", "Init / Recognize 使用的模型", "lang", "chi_sim_fast");
+    QCommandLineOption filterOpt("filter", "只运行名称包含该子串的用例", "text");
+    QCommandLineOption jsonOpt("json", "把结果写成 JSON", "file");
+    QCommandLineOption labelOpt("label", "写入 JSON 的运行标签，如提交号", "text");
+    QCommandLineOption baselineOpt("baseline", "与之前的 JSON 结果对比 p50", "file");
+    parser.addOptions({ itersOpt, heavyOpt, fixturesOpt, tessdataOpt, langOpt, filterOpt, jsonOpt, labelOpt, baselineOpt });
+    parser.process(app);
+
+    const int iters = qMax(1, parser.value(itersOpt).toInt());
+    const int heavyIters = qMax(1, parser.value(heavyOpt).toInt());
+    const QString filter = parser.value(filterOpt);
+    const QString tessdata = parser.value(tessdataOpt);
+    const QByteArray lang = parser.value(langOpt).toUtf8();
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    const QImage tmpl(QStringLiteral(":/assets/hshj.png"));
+    if (tmpl.isNull()) err << "警告: 未能加载 :/assets/hshj.png，合成截图不含模板\n";
+    const QList<Fixture> fixtures = loadFixtures(parser.value(fixturesOpt), tmpl);
+    if (fixtures.isEmpty()) {
+        err << "没有可用的截图\n";
+        return 1;
+    }
+
+    QList<CaseResult> results;
+    auto run = [&](const QString &name, const QString &fixture, int n, const std::function<void()> &fn) {
+        if (!filter.isEmpty() && !name.contains(filter)) return;
+        const CaseResult r = measure(name, fixture, n, fn);
+        out << r.name << ',' << r.fixture << ',' << r.iters << ','
+            << r.minMs << ',' << r.p50Ms << ',' << r.p90Ms << ',' << r.p99Ms << ',' << r.maxMs << ',' << r.meanMs << ','
+            << r.allocsPerCall << ',' << r.allocBytesPerCall << '\n';
+        out.flush();
+        results << r;
+    };
+    out << "case,fixture,iters,min_ms,p50_ms,p90_ms,p99_ms,max_ms,mean_ms,allocs_per_call,alloc_bytes_per_call\n";
+
+    // 与界面相同的默认配置（多线程尺度），只是不输出日志
+    Detector detector;
+
+    // Init 与截图无关，只测一次
+    run("tess_init", QString::fromUtf8(lang), heavyIters, [&]() {
+        tesseract::TessBaseAPI api;
+        if (api.Init(tessdata.toUtf8().constData(), lang.constData()) != 0) err << "Init 失败: " << tessdata << '\n';
+        api.End();
+    });
+
+    tesseract::TessBaseAPI api;
+    const bool apiReady = api.Init(tessdata.toUtf8().constData(), lang.constData()) == 0;
+    if (apiReady) {
+        api.SetPageSegMode(tesseract::PSM_AUTO);
+        api.SetVariable("user_defined_dpi", "96");
+    }
+
+    for (const Fixture &fx : fixtures) {
+        const QImage &img = fx.image;
+
+        run("gray_pix_legacy", fx.name, iters, [&]() { Pix *p = legacyGrayPix(img); pixDestroy(&p); });
+        run("gray_pix", fx.name, iters, [&]() { Pix *p = ImageConvert::toGrayPix(img); pixDestroy(&p); });
+
+        run("bgr_mat_legacy", fx.name, iters, [&]() { cv::Mat m = legacyBgr(img); });
+        cv::Mat reuse;
+        run("bgr_mat", fx.name, iters, [&]() { ImageConvert::toBgr(img, reuse); });
+        // 每次新建一帧并取齐模板、OCR、帧变化检测所需的平面；缓冲池稳态下不再分配像素缓冲
+        auto framePool = std::make_shared<FramePool>();
+        run("frame_planes", fx.name, iters, [&]() {
+            const Frame frame(img, framePool);
+            frame.bgr(); frame.gray(); frame.graySmall(8);
+        });
+
+        const TemplateMatcher::Mode modes[] = { TemplateMatcher::Mode::Exhaustive, TemplateMatcher::Mode::CoarseToFine };
+        for (TemplateMatcher::Mode mode : modes) {
+            const QString name = mode == TemplateMatcher::Mode::Exhaustive ? "template_exhaustive" : "template_coarse";
+            run(name, fx.name, heavyIters, [&]() { double score = 0; detector.runTemplateMatch(img, score, mode); });
+        }
+        // 特征点匹配与穷举对比：耗时进 JSON，定位结果写到标准错误（合成截图中模板按 0.7 倍贴在 (3/5, 1/4) 处）
+        const FeatureMatcher::Params featureDefaults = detector.matcher().features().params();
+        for (FeatureMatcher::Kind kind : { FeatureMatcher::Kind::Orb, FeatureMatcher::Kind::Akaze }) {
+            FeatureMatcher::Params fp = featureDefaults;
+            fp.kind = kind;
+            detector.matcher().features().setParams(fp);
+            const QString name = "template_features_" + FeatureMatcher::kindName(kind);
+            if (!filter.isEmpty() && !name.contains(filter)) continue;
+            double score = 0, scale = 1.0;
+            QSize size;
+            const QPoint pt = detector.runTemplateMatch(img, score, TemplateMatcher::Mode::Features, &size, &scale);
+            err << QString("%1 %2: pos=(%3,%4) scale=%5 score=%6\n").arg(name, fx.name).arg(pt.x()).arg(pt.y())
+                   .arg(scale, 0, 'f', 3).arg(score, 0, 'f', 4);
+            run(name, fx.name, heavyIters, [&]() {
+                double s = 0;
+                detector.runTemplateMatch(img, s, TemplateMatcher::Mode::Features);
+            });
+        }
+        detector.matcher().features().setParams(featureDefaults);
+
+        // 跟踪：已知上次位置时只在附近窗口匹配
+        {
+            TemplateTracker tracker(detector);
+            tracker.process(img, TemplateMatcher::Mode::Exhaustive);
+            run("template_track", fx.name, heavyIters, [&]() { tracker.process(img, TemplateMatcher::Mode::Exhaustive); });
+        }
+
+        if (apiReady) {
+            Pix *pix = ImageConvert::toGrayPix(img);
+            run("tess_recognize", fx.name, heavyIters, [&]() {
+                api.SetImage(pix);
+                api.Recognize(nullptr);
+                api.Clear();
+            });
+            pixDestroy(&pix);
+        }
+
+        const TextRegionDetector textRegions;
+        run("text_regions", fx.name, iters, [&]() { QVector<QRect> lines = textRegions.detect(img); });
+
+        const QPoint pt(img.width() * 3 / 5, img.height() / 4);
+        const QRect box(pt, QSize(120, 40));
+        run("render_marks", fx.name, iters, [&]() { QImage preview = MarkRender::render(img, pt, box, box.translated(0, 50)); });
+        // 同一帧重复绘制：底图已缓存，只画标记
+        MarkRender::PreviewCache previewCache;
+        previewCache.render(img, pt, box, QRect());
+        run("render_marks_cached", fx.name, iters, [&]() { QImage preview = previewCache.render(img, pt, box, box.translated(0, 50)); });
+
+        // 结果缓存：命中路径为取哈希 + 在满载的缓存中查找；
+        // 哈希取自帧上已由帧变化检测算好的缩小灰度图，这里先算好以反映管线中的实际代价
+        const Frame hashed(img);
+        hashed.graySmall(8);
+        ResultCache cache;
+        for (int i = 0; i < 63; ++i) {
+            const QImage other = img.copy(QRect(QPoint(i * 7, i * 3), img.size()));
+            cache.storeTemplate(ResultCache::hash(other), QStringLiteral("0"), TemplateResult{QPoint(-1, -1), 0.0, QSize()});
+        }
+        cache.storeTemplate(ResultCache::hash(hashed), QStringLiteral("0"), TemplateResult{pt, 0.9, box.size()});
+        run("result_cache_hit", fx.name, iters, [&]() {
+            TemplateResult r;
+            cache.lookupTemplate(ResultCache::hash(hashed), QStringLiteral("0"), &r);
+        });
+        // 命中后在缓存位置按原尺度复核一次，DetectRequest 采用缓存结果前的实际代价
+        run("result_cache_confirm", fx.name, iters, [&]() {
+            TemplateResult r;
+            if (cache.lookupTemplate(ResultCache::hash(hashed), QStringLiteral("0"), &r))
+                r = detector.runTemplateMatchNear(hashed, QRect(r.pt, r.size).adjusted(-2, -2, 2, 2), r.scale, 0);
+        });
+    }
+
+    // 截图：复用缓冲后稳态每帧应不再分配像素内存
+    QTemporaryDir frameDir;
+    if (frameDir.isValid() && (filter.isEmpty() || QString("capture_sequence").contains(filter))) {
+        for (const Fixture &fx : fixtures) {
+            const QString dir = QDir(frameDir.path()).filePath(fx.name);
+            QDir().mkpath(dir);
+            for (int i = 0; i < 3; ++i) fx.image.save(QDir(dir).filePath(QString("frame_%1.png").arg(i)));
+            ImageSequenceCapture seq(dir, true);
+            run("capture_sequence", fx.name, iters, [&]() { QImage frame = seq.grab(); });
+        }
+    }
+#ifdef DLDL_HAVE_XSHM
+    // 需要 X 服务器，例如 Xvfb :99 -screen 0 1920x1080x24 && DISPLAY=:99
+    if (!qEnvironmentVariableIsEmpty("DISPLAY")) {
+        XShmCapture xshm;
+        if (xshm.isValid()) {
+            const QImage probe = xshm.grab();
+            run("capture_xshm", QString("%1x%2").arg(probe.width()).arg(probe.height()), iters,
+                [&]() { QImage frame = xshm.grab(); });
+        } else {
+            err << "跳过 capture_xshm: 无法连接 X 服务器或不支持 MIT-SHM\n";
+        }
+    }
+#endif
+
+    if (apiReady) api.End();
+    else err << "跳过 tess_recognize: 无法用 " << tessdata << " 初始化 " << lang << '\n';
+
+    if (parser.isSet(jsonOpt)) {
+        QJsonArray cases;
+        for (const CaseResult &r : results) cases << toJson(r);
+        const QJsonObject doc{
+            {"label", parser.value(labelOpt)},
+            {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+            {"cpu_arch", QSysInfo::currentCpuArchitecture()},
+            {"os", QSysInfo::prettyProductName()},
+            {"qt", qVersion()},
+            {"opencv", CV_VERSION},
+            {"tesseract", tesseract::TessBaseAPI::Version()},
+            {"alloc_source", kAllocSource},
+            {"cases", cases}
+        };
+        QFile f(parser.value(jsonOpt));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "无法写入 " << f.fileName() << '\n';
+            return 1;
+        }
+        f.write(QJsonDocument(doc).toJson());
+    }
+
+    if (parser.isSet(baselineOpt)) {
+        QFile f(parser.value(baselineOpt));
+        if (!f.open(QIODevice::ReadOnly)) {
+            err << "无法读取基线 " << f.fileName() << '\n';
+            return 1;
+        }
+        QHash<QString, double> base;
+        for (const QJsonValue &v : QJsonDocument::fromJson(f.readAll()).object().value("cases").toArray()) {
+            const QJsonObject o = v.toObject();
+            base.insert(o.value("name").toString() + '@' + o.value("fixture").toString(), o.value("p50_ms").toDouble());
+        }
+        err << "\n与基线对比 p50 (变化为正表示变慢):\n";
+        for (const CaseResult &r : results) {
+            const QString key = r.name + '@' + r.fixture;
+            if (!base.contains(key) || base.value(key) <= 0) continue;
+            const double delta = (r.p50Ms / base.value(key) - 1.0) * 100.0;
+            err << QString("  %1 %2 -> %3 ms (%4%5%)\n").arg(key, -36)
+                   .arg(base.value(key), 0, 'f', 3).arg(r.p50Ms, 0, 'f', 3)
+                   .arg(delta >= 0 ? "+" : "").arg(delta, 0, 'f', 1);
+        }
+    }
+    return 0;
+}
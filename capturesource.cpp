@@ -0,0 +1,373 @@
+#include "capturesource.h"
+
+#include <QCollator>
+#include <QDir>
+#include <algorithm>
+
+#include "stagemetrics.h"
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+// Xlib 的宏（Bool、None、Status 等）会与 Qt 冲突，放在最后引入
+#ifdef DLDL_HAVE_XSHM
+#  include <X11/Xlib.h>
+#  include <X11/Xutil.h>
+#  include <X11/extensions/XShm.h>
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif
+
+CaptureSource::~CaptureSource()
+{
+    releaseBuffers();
+}
+
+QImage CaptureSource::grab()
+{
+    StageTimer stage(Stage::Capture);
+    const QSize size = nextFrameSize();
+    if (size.isEmpty()) {
+        m_failures++;
+        return QImage();
+    }
+
+    // 复用尺寸相同且调用方已释放的缓冲
+    int slot = -1;
+    for (int i = 0; i < m_ring.size(); ++i) {
+        if (m_ring[i].image.size() == size && m_ring[i].image.isDetached()) { slot = i; break; }
+    }
+    if (slot < 0) {
+        // 尺寸变化后旧缓冲不再有用；仍被持有的内存由其 QImage 负责释放
+        for (int i = m_ring.size() - 1; i >= 0; --i) {
+            if (m_ring[i].image.size() != size) {
+                destroyBuffer(m_ring[i]);
+                m_ring.removeAt(i);
+            }
+        }
+        Buffer buf;
+        if (!createBuffer(size, buf)) {
+            m_failures++;
+            return QImage();
+        }
+        m_allocations++;
+        if (m_ring.size() >= m_ringSize) m_ringFull++;
+        m_ring.append(buf);
+        slot = m_ring.size() - 1;
+    }
+
+    if (!captureInto(m_ring[slot])) {
+        m_failures++;
+        return QImage();
+    }
+    m_frames++;
+    QImage frame = m_ring[slot].image;
+    // 超出环容量的临时缓冲交给调用方，用完即释放
+    if (m_ring.size() > m_ringSize) {
+        destroyBuffer(m_ring[slot]);
+        m_ring.removeAt(slot);
+    }
+    return frame;
+}
+
+bool CaptureSource::createBuffer(const QSize &size, Buffer &buf)
+{
+    buf.image = QImage(size, QImage::Format_ARGB32);
+    return !buf.image.isNull();
+}
+
+void CaptureSource::releaseBuffers()
+{
+    for (Buffer &buf : m_ring) destroyBuffer(buf);
+    m_ring.clear();
+}
+
+CaptureSource::Stats CaptureSource::stats() const
+{
+    Stats s;
+    s.frames = m_frames;
+    s.failures = m_failures;
+    s.allocations = m_allocations;
+    s.ringFull = m_ringFull;
+    return s;
+}
+
+bool CaptureSource::windowCaptureSupported()
+{
+#if defined(_WIN32) || defined(DLDL_HAVE_XSHM)
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::unique_ptr<CaptureSource> CaptureSource::createWindowCapture(quintptr windowId, LogFn log)
+{
+    std::unique_ptr<CaptureSource> source;
+#if defined(_WIN32)
+    if (windowId) source.reset(new GdiWindowCapture(windowId));
+#elif defined(DLDL_HAVE_XSHM)
+    std::unique_ptr<XShmCapture> x(new XShmCapture(windowId));
+    if (x->isValid()) source = std::move(x);
+    else if (log) log(LogLevel::Warning, "无法连接 X 服务器或不支持 MIT-SHM");
+#else
+    Q_UNUSED(windowId);
+#endif
+    if (source) source->setLogger(std::move(log));
+    return source;
+}
+
+// ---------------------------------------------------------------------------
+// 图片序列
+
+ImageSequenceCapture::ImageSequenceCapture(const QString &dir, bool loop)
+    : m_dir(dir), m_files(listFrames(dir)), m_loop(loop)
+{
+}
+
+QStringList ImageSequenceCapture::listFrames(const QString &dir)
+{
+    QStringList files = QDir(dir).entryList(QStringList() << "*.png" << "*.PNG", QDir::Files);
+    // 自然排序，frame_2.png 排在 frame_10.png 之前
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(files.begin(), files.end(),
+              [&collator](const QString &a, const QString &b) { return collator.compare(a, b) < 0; });
+    return files;
+}
+
+bool ImageSequenceCapture::readFrame(QImageReader &reader, QImage *image)
+{
+    // 尺寸与格式一致时 QImageReader 直接解码进已有缓冲
+    if (!reader.read(image)) return false;
+    // 与窗口截图保持一致的像素格式
+    if (image->format() != QImage::Format_ARGB32 && image->format() != QImage::Format_RGB32)
+        *image = image->convertToFormat(QImage::Format_ARGB32);
+    return true;
+}
+
+QSize ImageSequenceCapture::nextFrameSize()
+{
+    // 跳过无法读取的文件
+    while (!m_files.isEmpty()) {
+        if (m_next >= m_files.size()) {
+            if (!m_loop) return QSize();
+            m_next = 0;
+        }
+        m_reader.setFileName(QDir(m_dir).filePath(m_files.at(m_next++)));
+        const QSize size = m_reader.size();
+        if (!size.isEmpty()) return size;
+        log(QString("无法读取帧: %1").arg(m_reader.fileName()), LogLevel::Warning);
+        if (!m_loop && m_next >= m_files.size()) return QSize();
+    }
+    return QSize();
+}
+
+bool ImageSequenceCapture::captureInto(Buffer &buf)
+{
+    return readFrame(m_reader, &buf.image);
+}
+
+bool ImageSequenceCapture::atEnd() const
+{
+    return !m_loop && m_next >= m_files.size();
+}
+
+QString ImageSequenceCapture::name() const
+{
+    return QString("dir:%1 (%2 帧)").arg(m_dir).arg(m_files.size());
+}
+
+// ---------------------------------------------------------------------------
+// Windows GDI
+
+#ifdef _WIN32
+GdiWindowCapture::GdiWindowCapture(quintptr hwnd)
+    : m_hwnd(hwnd)
+{
+    m_memDC = CreateCompatibleDC(nullptr);
+}
+
+GdiWindowCapture::~GdiWindowCapture()
+{
+    releaseBuffers();
+    if (m_memDC) DeleteDC(static_cast<HDC>(m_memDC));
+}
+
+QString GdiWindowCapture::name() const
+{
+    return QString("window:0x%1").arg((qulonglong)m_hwnd, 0, 16);
+}
+
+QSize GdiWindowCapture::nextFrameSize()
+{
+    RECT rc;
+    if (!GetWindowRect(reinterpret_cast<HWND>(m_hwnd), &rc)) return QSize();
+    return QSize(rc.right - rc.left, rc.bottom - rc.top);
+}
+
+bool GdiWindowCapture::createBuffer(const QSize &size, Buffer &buf)
+{
+    BITMAPINFO bmi; ZeroMemory(&bmi, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = size.width();
+    bmi.bmiHeader.biHeight = -size.height(); // top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+
+    void *bits = nullptr;
+    HBITMAP hbm = CreateDIBSection(static_cast<HDC>(m_memDC), &bmi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!hbm || !bits) {
+        log("CreateDIBSection失败", LogLevel::Warning);
+        return false;
+    }
+    // DIB 内存随最后一个引用它的 QImage 释放
+    buf.image = QImage(static_cast<uchar *>(bits), size.width(), size.height(), size.width() * 4,
+                       QImage::Format_ARGB32, [](void *hbm) { DeleteObject(static_cast<HBITMAP>(hbm)); }, hbm);
+    buf.native = hbm;
+    return true;
+}
+
+bool GdiWindowCapture::captureInto(Buffer &buf)
+{
+    HWND hwnd = reinterpret_cast<HWND>(m_hwnd);
+    HDC hdcWindow = GetWindowDC(hwnd);
+    if (!hdcWindow) { log("GetWindowDC失败", LogLevel::Warning); return false; }
+    HDC hdcMem = static_cast<HDC>(m_memDC);
+    HGDIOBJ old = SelectObject(hdcMem, static_cast<HBITMAP>(buf.native));
+    const BOOL ok = BitBlt(hdcMem, 0, 0, buf.image.width(), buf.image.height(), hdcWindow, 0, 0, SRCCOPY | CAPTUREBLT);
+    SelectObject(hdcMem, old);
+    ReleaseDC(hwnd, hdcWindow);
+    GdiFlush();
+    if (!ok) log("BitBlt失败", LogLevel::Warning);
+    return ok;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// X11 MIT-SHM
+
+#ifdef DLDL_HAVE_XSHM
+namespace {
+
+// 默认的 Xlib 错误处理会直接退出进程；窗口关闭等错误只记录下来
+std::atomic<int> s_lastXError{0};
+int recordXError(Display *, XErrorEvent *e)
+{
+    s_lastXError = e->error_code;
+    return 0;
+}
+
+struct ShmBuffer {
+    XImage *image = nullptr;
+    XShmSegmentInfo info{};
+};
+
+} // namespace
+
+struct XShmCapture::Private {
+    Display *dpy = nullptr;
+    bool shm = false;
+    Visual *visual = nullptr;
+    int depth = 0;
+};
+
+XShmCapture::XShmCapture(quintptr window, const QByteArray &display)
+    : d(new Private), m_window(window)
+{
+    d->dpy = XOpenDisplay(display.isEmpty() ? nullptr : display.constData());
+    if (!d->dpy) return;
+    XSetErrorHandler(&recordXError);
+    d->shm = XShmQueryExtension(d->dpy);
+    if (!m_window) m_window = DefaultRootWindow(d->dpy);
+}
+
+XShmCapture::~XShmCapture()
+{
+    releaseBuffers();
+    if (d->dpy) XCloseDisplay(d->dpy);
+}
+
+bool XShmCapture::isValid() const
+{
+    return d->dpy && d->shm;
+}
+
+QString XShmCapture::name() const
+{
+    return QString("x11:0x%1").arg((qulonglong)m_window, 0, 16);
+}
+
+QSize XShmCapture::nextFrameSize()
+{
+    if (!isValid()) return QSize();
+    XWindowAttributes attr;
+    if (!XGetWindowAttributes(d->dpy, (Window)m_window, &attr)) return QSize();
+    d->visual = attr.visual;
+    d->depth = attr.depth;
+    return QSize(attr.width, attr.height);
+}
+
+bool XShmCapture::createBuffer(const QSize &size, Buffer &buf)
+{
+    std::unique_ptr<ShmBuffer> sb(new ShmBuffer);
+    sb->image = XShmCreateImage(d->dpy, d->visual, d->depth, ZPixmap, nullptr, &sb->info,
+                                size.width(), size.height());
+    if (!sb->image) return false;
+    if (sb->image->bits_per_pixel != 32) {
+        log(QString("[截图] 不支持的像素位数 %1").arg(sb->image->bits_per_pixel), LogLevel::Warning);
+        XDestroyImage(sb->image);
+        return false;
+    }
+    sb->info.shmid = shmget(IPC_PRIVATE, size_t(sb->image->bytes_per_line) * sb->image->height, IPC_CREAT | 0600);
+    if (sb->info.shmid < 0) {
+        XDestroyImage(sb->image);
+        return false;
+    }
+    sb->info.shmaddr = sb->image->data = static_cast<char *>(shmat(sb->info.shmid, nullptr, 0));
+    sb->info.readOnly = False;
+    s_lastXError = 0;
+    const bool attached = sb->info.shmaddr != reinterpret_cast<char *>(-1) && XShmAttach(d->dpy, &sb->info);
+    XSync(d->dpy, False);
+    // 标记删除：X 服务器与本进程都分离后自动释放
+    shmctl(sb->info.shmid, IPC_RMID, nullptr);
+    if (!attached || s_lastXError) {
+        log("[截图] XShmAttach 失败", LogLevel::Warning);
+        if (sb->info.shmaddr != reinterpret_cast<char *>(-1)) shmdt(sb->info.shmaddr);
+        sb->image->data = nullptr;
+        XDestroyImage(sb->image);
+        return false;
+    }
+
+    // 32 位 ZPixmap 在小端机器上即 BGRX，对应 Format_RGB32；内存随最后一个 QImage 分离
+    buf.image = QImage(reinterpret_cast<uchar *>(sb->image->data), size.width(), size.height(),
+                       sb->image->bytes_per_line, QImage::Format_RGB32,
+                       [](void *addr) { shmdt(addr); }, sb->info.shmaddr);
+    buf.native = sb.release();
+    return true;
+}
+
+void XShmCapture::destroyBuffer(Buffer &buf)
+{
+    ShmBuffer *sb = static_cast<ShmBuffer *>(buf.native);
+    if (!sb) return;
+    XShmDetach(d->dpy, &sb->info);
+    // 共享内存由 QImage 的清理函数 shmdt，这里只释放 XImage 结构
+    sb->image->data = nullptr;
+    XDestroyImage(sb->image);
+    delete sb;
+    buf.native = nullptr;
+}
+
+bool XShmCapture::captureInto(Buffer &buf)
+{
+    ShmBuffer *sb = static_cast<ShmBuffer *>(buf.native);
+    s_lastXError = 0;
+    const bool ok = XShmGetImage(d->dpy, (Window)m_window, sb->image, 0, 0, AllPlanes) && !s_lastXError;
+    if (!ok && LogSink::enabled(LogLevel::Debug)) log(QString("[截图] XShmGetImage 失败 错误码=%1").arg(s_lastXError.load()), LogLevel::Debug);
+    return ok;
+}
+#endif
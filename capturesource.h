@@ -0,0 +1,149 @@
+#ifndef CAPTURESOURCE_H
+#define CAPTURESOURCE_H
+
+#include <QImage>
+#include <QImageReader>
+#include <QList>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+#include "framesource.h"
+#include "logsink.h"
+
+// 复用帧缓冲的截图后端
+// 内部维护一个小的缓冲环：grab() 交出的 QImage 与环中缓冲共享数据，调用方释放后该缓冲即可复用，
+// 尺寸不变且调用方不长期持有帧时，稳态下每帧不再分配内存。
+// 平台缓冲（共享内存、DIB）的释放挂在 QImage 的清理函数上，截图源先于帧销毁也是安全的。
+class CaptureSource : public FrameSource
+{
+public:
+    using LogFn = ::LogFn;
+
+    struct Stats {
+        qint64 frames = 0;
+        qint64 failures = 0;
+        qint64 allocations = 0;     // 新建的缓冲数
+        qint64 ringFull = 0;        // 环中缓冲都被占用、临时扩容的次数
+    };
+
+    ~CaptureSource() override;
+
+    QImage grab() override;
+
+    // 截取的窗口（Windows 为 HWND，X11 为 Window），0 表示整个屏幕
+    virtual quintptr windowId() const { return 0; }
+    Stats stats() const;
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+    // 环中最多保留的缓冲数，默认 3（采集、识别、界面各持有一帧）
+    void setRingSize(int n) { m_ringSize = qMax(1, n); }
+
+    // 当前平台的窗口截图后端，不支持时返回空
+    static std::unique_ptr<CaptureSource> createWindowCapture(quintptr windowId, LogFn log = LogFn());
+    static bool windowCaptureSupported();
+
+protected:
+    struct Buffer {
+        QImage image;               // 包装缓冲内存，格式为 ARGB32 / RGB32
+        void *native = nullptr;     // 后端私有句柄
+    };
+
+    // 下一帧的尺寸，失败返回空
+    virtual QSize nextFrameSize() = 0;
+    // 为该尺寸创建缓冲；默认在堆上分配
+    virtual bool createBuffer(const QSize &size, Buffer &buf);
+    // 释放后端句柄；像素内存由 image 的清理函数负责
+    virtual void destroyBuffer(Buffer &buf) { Q_UNUSED(buf); }
+    // 把下一帧写入 buf.image 的内存
+    virtual bool captureInto(Buffer &buf) = 0;
+
+    void releaseBuffers();
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+private:
+    QList<Buffer> m_ring;
+    int m_ringSize = 3;
+    std::atomic<qint64> m_frames{0};
+    std::atomic<qint64> m_failures{0};
+    std::atomic<qint64> m_allocations{0};
+    std::atomic<qint64> m_ringFull{0};
+    LogFn m_log;
+};
+
+// 目录中的 PNG 序列，按文件名自然排序；loop 为 true 时循环播放。
+// 尺寸与像素格式不变时解码直接写入复用的缓冲。
+class ImageSequenceCapture : public CaptureSource
+{
+public:
+    explicit ImageSequenceCapture(const QString &dir, bool loop = false);
+    bool atEnd() const override;
+    QString name() const override;
+    int frameCount() const { return m_files.size(); }
+
+    // 目录中的 PNG 文件名，自然排序（frame_2.png 在 frame_10.png 之前）；回放来源共用
+    static QStringList listFrames(const QString &dir);
+    // 读取下一帧到 image（尺寸与格式一致时直接解码进已有缓冲），并统一为 ARGB32 / RGB32
+    static bool readFrame(QImageReader &reader, QImage *image);
+
+protected:
+    QSize nextFrameSize() override;
+    bool captureInto(Buffer &buf) override;
+
+private:
+    QString m_dir;
+    QStringList m_files;
+    int m_next = 0;
+    bool m_loop;
+    QImageReader m_reader;
+};
+
+#ifdef _WIN32
+// GDI BitBlt 直接写入复用的 DIB section
+class GdiWindowCapture : public CaptureSource
+{
+public:
+    explicit GdiWindowCapture(quintptr hwnd);
+    ~GdiWindowCapture() override;
+    quintptr windowId() const override { return m_hwnd; }
+    QString name() const override;
+
+protected:
+    QSize nextFrameSize() override;
+    bool createBuffer(const QSize &size, Buffer &buf) override;
+    bool captureInto(Buffer &buf) override;
+
+private:
+    quintptr m_hwnd;
+    void *m_memDC = nullptr;
+};
+#endif
+
+#ifdef DLDL_HAVE_XSHM
+// X11 MIT-SHM：X 服务器把窗口内容直接写进共享内存，QImage 包装同一块内存，无拷贝。
+// 可在 Xvfb 下运行（DISPLAY=:99）。
+class XShmCapture : public CaptureSource
+{
+public:
+    // display 为空时使用 DISPLAY 环境变量；window 为 0 时截取根窗口
+    explicit XShmCapture(quintptr window = 0, const QByteArray &display = QByteArray());
+    ~XShmCapture() override;
+    bool isValid() const;
+    quintptr windowId() const override { return m_window; }
+    QString name() const override;
+
+protected:
+    QSize nextFrameSize() override;
+    bool createBuffer(const QSize &size, Buffer &buf) override;
+    void destroyBuffer(Buffer &buf) override;
+    bool captureInto(Buffer &buf) override;
+
+private:
+    struct Private;
+    std::unique_ptr<Private> d;
+    quintptr m_window;
+};
+#endif
+
+#endif // CAPTURESOURCE_H
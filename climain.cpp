@@ -0,0 +1,420 @@
+// 命令行批处理：对截图目录 / 通配符 / 单个文件并行执行模板匹配与 OCR，
+// 每张图输出一行 JSON（JSON Lines），附各阶段耗时，便于回归测试识别速度。
+// --replay 回放录制的会话（视频或带时间戳的 PNG 序列），走与界面“执行”相同的识别路径并报告吞吐。
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QCollator>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+
+#include "appconfig.h"
+#include "detector.h"
+#include "detectrequest.h"
+#include "detectscheduler.h"
+#include "frame.h"
+#include "ocrcascade.h"
+#include "replaysource.h"
+#include "resultcache.h"
+#include "stagemetrics.h"
+#include "templatetracker.h"
+
+namespace {
+
+// 展开输入：目录取其中图片，含通配符的按文件名匹配，其余视为单个文件
+QStringList expandInputs(const QStringList &args)
+{
+    const QStringList imageFilters = { "*.png", "*.PNG", "*.jpg", "*.JPG", "*.jpeg", "*.bmp" };
+    QCollator collator;
+    collator.setNumericMode(true);
+    auto naturalLess = [&collator](const QString &a, const QString &b) { return collator.compare(a, b) < 0; };
+
+    QStringList files;
+    for (const QString &arg : args) {
+        QFileInfo fi(arg);
+        if (fi.isDir()) {
+            QDir dir(arg);
+            QStringList names = dir.entryList(imageFilters, QDir::Files);
+            std::sort(names.begin(), names.end(), naturalLess);
+            for (const QString &n : names) files << dir.filePath(n);
+        } else if (arg.contains('*') || arg.contains('?')) {
+            QDir dir(fi.path());
+            QStringList names = dir.entryList(QStringList() << fi.fileName(), QDir::Files);
+            std::sort(names.begin(), names.end(), naturalLess);
+            for (const QString &n : names) files << dir.filePath(n);
+        } else {
+            files << arg;
+        }
+    }
+    return files;
+}
+
+QJsonObject rectJson(const QRect &r)
+{
+    return QJsonObject{ {"x", r.x()}, {"y", r.y()}, {"w", r.width()}, {"h", r.height()} };
+}
+
+struct ReplayOptions {
+    QString path;
+    ReplaySource::Pacing pacing = ReplaySource::Pacing::Realtime;
+    double fps = 30.0;
+    TemplateMatcher::Mode matchMode = TemplateMatcher::Mode::Exhaustive;
+    OcrCascade::Mode ocrMode = OcrCascade::Mode::Cascade;
+    bool doOcr = true;
+    ResultCache *cache = nullptr;
+    TemplateTracker *tracker = nullptr;
+};
+
+// 回放：逐帧提交给“只做最新一次”的调度器，与界面点击“执行”相同。
+// 原速回放时识别跟不上的帧被合并或丢弃；全速回放等上一帧识别完再取下一帧，测的是识别能力上限。
+int runReplay(const ReplayOptions &opt, Detector &detector, OcrCascade &cascade, QFile &out, QTextStream &err)
+{
+    ReplaySource source(opt.path, opt.pacing, opt.fps);
+    if (!source.isValid()) {
+        err << "无法打开回放: " << opt.path << '\n';
+        return 1;
+    }
+    err << "回放: " << source.name() << '\n';
+    err.flush();
+
+    DetectScheduler scheduler;
+    // 回放帧尺寸固定，灰度 / BGR 缓冲在帧之间复用
+    auto framePool = std::make_shared<FramePool>();
+    QMutex mutex;
+    QRect lastOcrRect;
+    qint64 detections = 0, templateHits = 0, ocrHits = 0;
+    double latencySumMs = 0.0, latencyMaxMs = 0.0;
+    qint64 frames = 0;
+    QElapsedTimer wall; wall.start();
+    for (;;) {
+        const QImage frame = source.grab();
+        if (frame.isNull()) {
+            if (source.atEnd()) break;
+            continue;
+        }
+        frames++;
+        if (opt.pacing == ReplaySource::Pacing::AsFastAsPossible) scheduler.waitForIdle();
+
+        DetectRequest req;
+        req.frame = Frame(frame, framePool);
+        req.matchMode = opt.matchMode;
+        req.ocrMode = opt.ocrMode;
+        req.runOcr = opt.doOcr;
+        req.cache = opt.cache;
+        req.tracker = opt.tracker;
+        {
+            QMutexLocker lock(&mutex);
+            req.lastOcrRect = lastOcrRect;
+        }
+        const qint64 index = frames;
+        const qint64 ts = source.lastTimestampMs();
+        scheduler.submit([&, req, index, ts](const DetectScheduler::Ticket &t) {
+            const DetectRequest::Response resp = req.run(detector, cascade, t.cancel);
+            if (!scheduler.acceptResult(t.generation) || resp.tmpl.cancelled
+                || (resp.ocrRan && resp.ocr.final.cancelled)) return;
+
+            QJsonObject row{ {"frame", index}, {"ts_ms", ts}, {"latency_ms", resp.totalMs} };
+            const bool tmplFound = resp.tmpl.pt.x() >= 0;
+            QJsonObject tmpl = tmplFound ? rectJson(QRect(resp.tmpl.pt, resp.tmpl.size)) : QJsonObject();
+            tmpl["found"] = tmplFound;
+            tmpl["score"] = resp.tmpl.score;
+            if (tmplFound) tmpl["scale"] = resp.tmpl.scale;
+            row["template"] = tmpl;
+            const QRect ocrRect = resp.ocr.final.rect;
+            if (resp.ocrRan) {
+                QJsonObject ocr = ocrRect.isValid() ? rectJson(ocrRect) : QJsonObject();
+                ocr["found"] = ocrRect.isValid();
+                ocr["lang"] = resp.ocr.final.lang;
+                row["ocr"] = ocr;
+            }
+
+            QMutexLocker lock(&mutex);
+            if (resp.ocrRan) lastOcrRect = ocrRect;
+            detections++;
+            if (tmplFound) templateHits++;
+            if (ocrRect.isValid()) ocrHits++;
+            latencySumMs += resp.totalMs;
+            latencyMaxMs = qMax(latencyMaxMs, resp.totalMs);
+            out.write(QJsonDocument(row).toJson(QJsonDocument::Compact) + '\n');
+            out.flush();
+        });
+    }
+    scheduler.waitForIdle();
+    const double wallSec = qMax(1e-9, wall.nsecsElapsed() / 1e9);
+
+    const DetectScheduler::Stats s = scheduler.stats();
+    const qint64 dropped = source.skipped() + s.coalesced + s.staleDropped;
+    err << QString("回放完成: 帧=%1 (%2帧/s) 识别=%3 (%4次/s) 丢弃=%5 (回放跳帧 %6 / 排队合并 %7 / 过期 %8)\n")
+           .arg(frames).arg(frames / wallSec, 0, 'f', 1).arg(detections).arg(detections / wallSec, 0, 'f', 2)
+           .arg(dropped).arg(source.skipped()).arg(s.coalesced).arg(s.staleDropped);
+    err << QString("       模板命中 %1 OCR命中 %2 识别延迟 avg=%3ms max=%4ms 用时=%5s\n")
+           .arg(templateHits).arg(ocrHits).arg(detections ? latencySumMs / detections : 0.0, 0, 'f', 1)
+           .arg(latencyMaxMs, 0, 'f', 1).arg(wallSec, 0, 'f', 2);
+    err << "       " << framePool->summary() << '\n';
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("dldl-lhsj-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("批量识别截图中的“魂兽幻境”，结果以 JSON Lines 输出");
+    parser.addHelpOption();
+    parser.addPositionalArgument("inputs", "图片目录、通配符（如 shots/*.png）或图片文件", "<inputs...>");
+    QCommandLineOption replayOpt("replay", "回放录制的会话：视频文件或 PNG 序列目录（可含 timestamps.txt）", "path");
+    QCommandLineOption replaySpeedOpt("replay-speed", "回放速度 realtime（原速）/ max（全速）", "speed", "realtime");
+    QCommandLineOption noCacheOpt("no-cache", "回放时不复用相同画面的识别结果（配置 [cache] enabled 开启时才有缓存）");
+    QCommandLineOption replayFpsOpt("replay-fps", "PNG 序列无时间戳时的帧率", "fps", "30");
+    QCommandLineOption langOpt("lang", "OCR 语言变体（chi_sim_fast / chi_sim_accuracy / chi_sim）", "lang", "chi_sim_fast");
+    QCommandLineOption modeOpt("mode", "模板匹配模式 exhaustive / coarse / compare / features", "mode", "exhaustive");
+    QCommandLineOption threadsOpt({"j", "threads"}, "并行处理的图片数，0 表示 CPU 核数", "n", "0");
+    QCommandLineOption outOpt({"o", "out"}, "结果输出文件，默认标准输出", "file");
+    QCommandLineOption configOpt("config", "配置文件路径，默认程序目录下的 dldl-lhsj.ini", "file");
+    QCommandLineOption keywordsOpt("keywords", "逗号分隔的 OCR 关键词，第一项为主标签（默认取配置文件）", "list");
+    QCommandLineOption ocrModeOpt("ocr-mode", "OCR 调度 single（仅 --lang）/ parallel / cascade / speculative", "mode", "single");
+    QCommandLineOption linesOpt("ocr-lines", "整图 OCR 改为检测候选文本行后逐行并行识别");
+    QCommandLineOption fullTextOpt("full-text", "额外输出 OCR 识别全文");
+    QCommandLineOption noOcrOpt("no-ocr", "跳过 OCR");
+    QCommandLineOption noTmplOpt("no-template", "跳过模板匹配");
+    QCommandLineOption verboseOpt({"v", "verbose"}, "把识别日志输出到标准错误");
+    QCommandLineOption metricsOpt("metrics", "结束时写出分阶段耗时（.prom 为 Prometheus 文本，否则 JSON）", "file");
+    QCommandLineOption logLevelOpt("log-level", "配合 --verbose 使用的日志级别 debug / info / warning / error", "level", "info");
+    parser.addOptions({ langOpt, modeOpt, threadsOpt, outOpt, configOpt, noOcrOpt, noTmplOpt, verboseOpt, logLevelOpt, metricsOpt,
+                        keywordsOpt, fullTextOpt, ocrModeOpt, replayOpt, replaySpeedOpt, replayFpsOpt, noCacheOpt, linesOpt });
+    parser.process(app);
+
+    QTextStream err(stderr);
+    const bool replay = parser.isSet(replayOpt);
+    const QStringList files = expandInputs(parser.positionalArguments());
+    if (files.isEmpty() && !replay) {
+        err << "没有可处理的图片\n";
+        parser.showHelp(1);
+    }
+
+    const QString modeArg = parser.value(modeOpt).toLower();
+    TemplateMatcher::Mode mode = TemplateMatcher::Mode::Exhaustive;
+    if (modeArg == "coarse") mode = TemplateMatcher::Mode::CoarseToFine;
+    else if (modeArg == "compare") mode = TemplateMatcher::Mode::Compare;
+    else if (modeArg == "features") mode = TemplateMatcher::Mode::Features;
+    else if (modeArg != "exhaustive") {
+        err << "未知的匹配模式: " << modeArg << '\n';
+        return 1;
+    }
+
+    int threads = parser.value(threadsOpt).toInt();
+    if (threads <= 0) threads = QThread::idealThreadCount();
+    // 批量模式线程数不超过图片数；回放没有文件列表，--threads 决定每种语言的引擎数（行识别并行度）
+    if (!replay) threads = qMin(threads, (int)files.size());
+    threads = qMax(1, threads);
+
+    const bool doOcr = !parser.isSet(noOcrOpt);
+    const bool doTemplate = !parser.isSet(noTmplOpt);
+    const QString lang = parser.value(langOpt);
+    const QString ocrModeArg = parser.value(ocrModeOpt).toLower();
+    // 回放走界面的识别路径，始终使用级联调度
+    const bool cascade = ocrModeArg != "single" || replay;
+    const OcrCascade::Mode ocrMode = OcrCascade::parseMode(ocrModeArg, replay ? OcrCascade::Mode::Cascade : OcrCascade::Mode::Count);
+    if (cascade && ocrMode == OcrCascade::Mode::Count) {
+        err << "未知的 OCR 调度: " << ocrModeArg << '\n';
+        return 1;
+    }
+
+    AppConfig config = AppConfig::load(parser.isSet(configOpt) ? parser.value(configOpt) : AppConfig::defaultPath());
+    // 并行粒度为图片，单张图内的尺度串行执行，避免线程数相乘；回放一次只识别一帧，保留配置
+    if (!replay) config.matchThreads = 1;
+    if (parser.isSet(keywordsOpt)) {
+        const QStringList keywords = parser.value(keywordsOpt).split(',', Qt::SkipEmptyParts);
+        if (!keywords.isEmpty()) config.ocrKeywords = keywords;
+    }
+    if (parser.isSet(linesOpt)) config.ocrLineMode = true;
+    const bool fullText = parser.isSet(fullTextOpt);
+    if (fullText && cascade) err << "--full-text 仅在 --ocr-mode single 下输出\n";
+
+    QMutex errMutex;
+    Detector detector(config);
+    if (parser.isSet(verboseOpt)) {
+        LogSink::setLevel(LogSink::parseLevel(parser.value(logLevelOpt)));
+        detector.setLogger([&err, &errMutex](LogLevel level, const QString &msg) {
+            if (!LogSink::enabled(level)) return;
+            QMutexLocker lock(&errMutex);
+            err << msg << '\n';
+            err.flush();
+        });
+    }
+    // 每个工作线程独占一个引擎
+    detector.ocrPool().setMaxPerLang(threads);
+    OcrCascade ocrCascade(detector);
+    ocrCascade.setMinConfidence(float(config.ocrCascadeMinConfidence));
+    if (doOcr) {
+        if (cascade) detector.warmUp({ QStringLiteral("chi_sim_fast"), QStringLiteral("chi_sim_accuracy") }, threads);
+        else detector.warmUp({ lang }, threads);
+    }
+
+    QFile outFile;
+    if (parser.isSet(outOpt)) {
+        outFile.setFileName(parser.value(outOpt));
+        if (!outFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "无法写入输出文件: " << outFile.fileName() << '\n';
+            return 1;
+        }
+    } else {
+        outFile.open(stdout, QIODevice::WriteOnly);
+    }
+
+    auto finish = [&](int code) {
+        if (doOcr) err << detector.ocrPool().metricsSummary() << '\n';
+        if (doOcr && parser.isSet(verboseOpt)) err << "模型: " << detector.tessdata().summary() << '\n';
+        if (doOcr && cascade) err << "OCR调度: " << ocrCascade.statsSummary() << '\n';
+        err << StageMetrics::summaryText();
+        if (parser.isSet(metricsOpt)) {
+            QString error;
+            if (!StageMetrics::dumpToFile(parser.value(metricsOpt), &error))
+                err << "无法写入耗时统计: " << parser.value(metricsOpt) << " (" << error << ")\n";
+        }
+        err.flush();
+        return code;
+    };
+
+    if (replay) {
+        ReplayOptions opt;
+        opt.path = parser.value(replayOpt);
+        opt.pacing = ReplaySource::parsePacing(parser.value(replaySpeedOpt));
+        opt.fps = parser.value(replayFpsOpt).toDouble();
+        opt.matchMode = mode;
+        opt.ocrMode = ocrMode;
+        opt.doOcr = doOcr;
+        ResultCache cache(config.resultCacheCapacity, config.resultCacheTolerance);
+        if (config.resultCacheEnabled && !parser.isSet(noCacheOpt)) opt.cache = &cache;
+        TemplateTracker::Params trackParams;
+        trackParams.minScore = config.trackMinScore;
+        trackParams.margin = config.trackMargin;
+        TemplateTracker tracker(detector, trackParams);
+        if (config.templateTracking) opt.tracker = &tracker;
+        const int code = runReplay(opt, detector, ocrCascade, outFile, err);
+        if (opt.cache) err << cache.statsSummary() << '\n';
+        if (opt.tracker) err << tracker.statsSummary() << '\n';
+        return finish(code);
+    }
+
+    QMutex outMutex;
+    std::atomic<int> done{0};
+    std::atomic<int> loadFailures{0};
+    std::atomic<int> templateHits{0};
+    std::atomic<int> ocrHits{0};
+
+    auto processOne = [&](const QString &path) {
+        QElapsedTimer total; total.start();
+        QJsonObject row{ {"file", path} };
+
+        QElapsedTimer t; t.start();
+        QImage img(path);
+        if (!img.isNull() && img.format() != QImage::Format_ARGB32)
+            img = img.convertToFormat(QImage::Format_ARGB32);
+        const double loadMs = t.nsecsElapsed() / 1e6;
+        double templateMs = 0.0, ocrMs = 0.0;
+
+        if (img.isNull()) {
+            row["error"] = "load failed";
+            loadFailures++;
+        } else {
+            row["width"] = img.width();
+            row["height"] = img.height();
+            // 模板匹配与各 OCR 变体共用同一帧的派生平面
+            const Frame frame(img);
+
+            if (doTemplate) {
+                t.restart();
+                double score = 0.0;
+                QSize size;
+                double scale = 1.0;
+                const QPoint pt = detector.runTemplateMatch(frame, score, mode, &size, &scale);
+                templateMs = t.nsecsElapsed() / 1e6;
+                const bool found = pt.x() >= 0;
+                if (found) templateHits++;
+                QJsonObject tmpl = found ? rectJson(QRect(pt, size)) : QJsonObject();
+                tmpl["found"] = found;
+                tmpl["score"] = score;
+                if (found) tmpl["scale"] = scale;
+                row["template"] = tmpl;
+            }
+
+            if (doOcr) {
+                t.restart();
+                OcrResult r;
+                OcrCascade::Outcome o;
+                if (cascade) {
+                    o = ocrCascade.run(frame, QRect(), ocrMode);
+                    r = o.final;
+                } else {
+                    r = detector.runOcr(frame, lang, QRect(), fullText);
+                }
+                ocrMs = t.nsecsElapsed() / 1e6;
+                const bool found = r.rect.isValid();
+                if (found) ocrHits++;
+                QJsonObject ocr = found ? rectJson(r.rect) : QJsonObject();
+                ocr["found"] = found;
+                ocr["lang"] = r.lang.isEmpty() ? lang : r.lang;
+                if (cascade) {
+                    ocr["mode"] = OcrCascade::modeName(ocrMode);
+                    ocr["fast_accepted"] = o.fastAccepted;
+                    ocr["accuracy_ran"] = o.accuracyRan;
+                    ocr["accuracy_cancelled"] = o.accuracyCancelled;
+                    ocr["fast_ms"] = o.fastMs;
+                    ocr["accuracy_ms"] = o.accuracyMs;
+                }
+                QJsonArray hits;
+                for (const OcrHit &h : r.hits) {
+                    QJsonObject hitObj = rectJson(h.rect);
+                    hitObj["keyword"] = h.keyword;
+                    hitObj["conf"] = h.confidence;
+                    hits.append(hitObj);
+                }
+                ocr["hits"] = hits;
+                if (fullText && !cascade) ocr["text"] = r.text;
+                row["ocr"] = ocr;
+            }
+        }
+
+        row["timings"] = QJsonObject{
+            {"load_ms", loadMs}, {"template_ms", templateMs}, {"ocr_ms", ocrMs},
+            {"total_ms", total.nsecsElapsed() / 1e6}
+        };
+
+        const QByteArray line = QJsonDocument(row).toJson(QJsonDocument::Compact) + '\n';
+        QMutexLocker lock(&outMutex);
+        outFile.write(line);
+        outFile.flush();
+        done++;
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+    QElapsedTimer wall; wall.start();
+    for (const QString &path : files)
+        pool.start([&processOne, path]() { processOne(path); });
+    pool.waitForDone();
+    const double wallSec = wall.nsecsElapsed() / 1e9;
+
+    err << QString("完成 %1 张图 (加载失败 %2) 模板命中 %3 OCR命中 %4 线程=%5 用时=%6s 吞吐=%7张/s\n")
+           .arg(done.load()).arg(loadFailures.load()).arg(templateHits.load()).arg(ocrHits.load())
+           .arg(threads).arg(wallSec, 0, 'f', 2).arg(wallSec > 0 ? done.load() / wallSec : 0.0, 0, 'f', 1);
+    return finish(loadFailures.load() > 0 ? 2 : 0);
+}
@@ -0,0 +1,421 @@
+#include "detector.h"
+
+#include <QtConcurrent>
+#include <atomic>
+#include <opencv2/imgproc.hpp>
+
+#include <tesseract/baseapi.h>
+#include <tesseract/ocrclass.h>
+#include <leptonica/allheaders.h>
+
+#include "imageconvert.h"
+#include "stagemetrics.h"
+
+Detector::Detector(const AppConfig &config, LogFn log)
+    : m_log(std::move(log))
+{
+    m_templates.setLogger([this](LogLevel level, const QString &msg) { this->log(msg, level); });
+    m_matcher.setLogger([this](LogLevel level, const QString &msg) { this->log(msg, level); });
+    m_ocrPool.setLogger([this](LogLevel level, const QString &msg) { this->log(msg, level); });
+    m_models.setLogger([this](LogLevel level, const QString &msg) { this->log(msg, level); });
+    m_catalog.setLogger([this](LogLevel level, const QString &msg) { this->log(msg, level); });
+    m_catalog.scan();
+    m_ocrPool.setResolver([this](const QString &langCode, TessModelPtr *model, QString *langParam) {
+        TessdataCatalog::Entry entry;
+        if (!resolveTessdata(langCode, &entry, langParam)) return false;
+        *model = m_models.get(entry.path, entry.size, entry.modified);
+        return bool(*model);
+    });
+    setConfig(config);
+}
+
+Detector::~Detector()
+{
+    m_ocrPool.waitForWarmUp();
+}
+
+void Detector::setConfig(const AppConfig &config)
+{
+    m_config = config;
+    m_keywords.build(config.ocrKeywords);
+    TemplateMatcher::SearchParams search;
+    search.goodEnough = config.goodEnoughScore;
+    search.threads = config.matchThreads;
+    m_matcher.setSearchParams(search);
+    FeatureMatcher::Params features = m_matcher.features().params();
+    features.kind = FeatureMatcher::parseKind(config.featureType);
+    features.minInliers = config.featureMinInliers;
+    m_matcher.features().setParams(features);
+}
+
+QPoint Detector::runTemplateMatch(const Frame &screenshot, double &scoreOut, TemplateMatcher::Mode mode, QSize *sizeOut,
+                                  double *scaleOut, const CancelFn &cancel, bool *cancelledOut)
+{
+    if (cancelledOut) *cancelledOut = false;
+    StageTimer stage(Stage::TemplateMatch);
+    // 多尺度匹配：尺度范围与步长来自配置（默认1.0降到0.4），模板金字塔由注册表缓存
+    TemplateRegistry::PyramidPtr tmpl = m_templates.get(QStringLiteral("hshj"),
+        TemplateRegistry::scaleSteps(m_config.scaleMax, m_config.scaleMin, m_config.scaleStep));
+    if (!tmpl) {
+        log("模板图片加载失败: assets/hshj.png", LogLevel::Warning);
+        scoreOut = 0.0;
+        return QPoint(-1, -1);
+    }
+    log(QString("模板图片尺寸 %1x%2 模式=%3").arg(tmpl->size.width()).arg(tmpl->size.height())
+              .arg(TemplateMatcher::modeName(mode)));
+
+    // BGR 平面由帧缓存，同一帧的其他阶段不再重复转换
+    const cv::Mat &src3 = screenshot.bgr();
+
+    TemplateMatcher::Result best = m_matcher.match(src3, tmpl, mode, cancel);
+    if (best.cancelled) {
+        log(QString("模板匹配已取消 耗时=%1ms").arg(best.elapsedMs, 0, 'f', 1));
+        if (cancelledOut) *cancelledOut = true;
+        scoreOut = 0.0;
+        return QPoint(-1, -1);
+    }
+
+    scoreOut = (best.score < 0 ? 0.0 : best.score);
+    log(QString("模板匹配最佳：score=%1 scale=%2 size=%3x%4 耗时=%5ms")
+              .arg(scoreOut,0,'f',4).arg(best.scale,0,'f',2).arg(best.size.width).arg(best.size.height)
+              .arg(best.elapsedMs,0,'f',1));
+    if (!best.valid()) return QPoint(-1,-1);
+    if (sizeOut) *sizeOut = QSize(best.size.width, best.size.height);
+    if (scaleOut) *scaleOut = best.scale;
+    return QPoint(best.loc.x, best.loc.y);
+}
+
+TemplateResult Detector::runTemplateMatchNear(const Frame &screenshot, const QRect &window, double scale, int levelRadius)
+{
+    TemplateResult r{QPoint(-1, -1), 0.0, QSize()};
+    const QRect area = window.intersected(screenshot.rect());
+    TemplateRegistry::PyramidPtr tmpl = m_templates.get(QStringLiteral("hshj"),
+        TemplateRegistry::scaleSteps(m_config.scaleMax, m_config.scaleMin, m_config.scaleStep));
+    if (!tmpl || area.isEmpty()) return r;
+
+    StageTimer stage(Stage::TemplateMatch);
+    cv::Mat window3; ImageConvert::toBgr(screenshot.image(), window3, area);
+    const TemplateMatcher::Result best = m_matcher.matchNear(window3, *tmpl, scale, levelRadius);
+    if (tracing())
+        log(QString("[跟踪] 窗口(%1,%2,%3,%4) score=%5 scale=%6 耗时=%7ms").arg(area.x()).arg(area.y())
+            .arg(area.width()).arg(area.height()).arg(best.score, 0, 'f', 4).arg(best.scale, 0, 'f', 2)
+            .arg(best.elapsedMs, 0, 'f', 2), LogLevel::Debug);
+    if (!best.valid()) return r;
+    r.pt = QPoint(area.x() + best.loc.x, area.y() + best.loc.y);
+    r.score = best.score;
+    r.size = QSize(best.size.width, best.size.height);
+    r.scale = best.scale;
+    return r;
+}
+
+bool Detector::resolveTessdata(const QString &langCode, TessdataCatalog::Entry *model, QString *langParam)
+{
+    StageTimer stage(Stage::TessdataResolve);
+    // 启动时已扫描，这里只查表
+    TessdataCatalog::Entry entry;
+    if (!m_catalog.lookup(langCode, &entry)) {
+        log(QString("未检测到%1(.traineddata)，请将其放在程序目录tessdata/或设置TESSDATA_PREFIX").arg(langCode), LogLevel::Warning);
+        return false;
+    }
+
+    // 模型从内存初始化，变体文件无需复制为 chi_sim.traineddata，语言名仍使用标准名
+    const QString lp = langCode.startsWith("chi_sim") ? QStringLiteral("chi_sim") : langCode;
+    log(QString("[OCR] 使用模型=%1, lang=%2").arg(entry.path, lp));
+    if (model) *model = entry;
+    if (langParam) *langParam = lp;
+    return true;
+}
+
+namespace {
+
+// ETEXT_DESC::cancel 回调，cancelThis 指向 Detector::CancelFn
+bool cancelRecognition(void *cancelThis, int /*words*/)
+{
+    const Detector::CancelFn *fn = static_cast<const Detector::CancelFn *>(cancelThis);
+    return fn && *fn && (*fn)();
+}
+
+} // namespace
+
+QVector<OcrHit> Detector::findKeywords(const Frame &screenshot, const QString &langCode, const QRect &roi,
+                                       QString *fullTextOut, const CancelFn &cancel, bool *cancelledOut)
+{
+    bool cancelled = false;
+    if (cancelledOut) *cancelledOut = false;
+    if (cancel && cancel()) {
+        if (cancelledOut) *cancelledOut = true;
+        return {};
+    }
+    StageTimer stage(Stage::OcrFind);
+    if (tracing()) log(QString("[OCR] 查找关键词 %1 个, lang=%2").arg(m_keywords.keywords().size()).arg(langCode), LogLevel::Debug);
+
+    OcrEnginePool::Lease lease = m_ocrPool.acquire(langCode);
+    if (!lease) {
+        log(QString("Tesseract初始化失败(%1)" ).arg(langCode), LogLevel::Warning);
+        return {};
+    }
+    tesseract::TessBaseAPI &api = *lease.api();
+    api.SetVariable("user_defined_dpi", "96");
+
+    QVector<OcrHit> hits;
+    const QRect clipped = roi.intersected(screenshot.rect());
+    if (!clipped.isEmpty()) {
+        if (tracing())
+            log(QString("[%1] ROI识别: (%2,%3,%4,%5)").arg(langCode)
+                .arg(clipped.x()).arg(clipped.y()).arg(clipped.width()).arg(clipped.height()), LogLevel::Debug);
+        hits = recognizeKeywords(api, screenshot, clipped, langCode, fullTextOut, cancel, &cancelled);
+        if (cancelled) {
+            if (cancelledOut) *cancelledOut = true;
+            return {};
+        }
+        if (!bestHit(hits, primaryKeyword())) {
+            log(QString("[%1] ROI未命中，回退全图识别").arg(langCode));
+            api.Clear();
+            hits.clear();
+        }
+    }
+    if (hits.isEmpty() && m_config.ocrLineMode && !fullTextOut) {
+        const QVector<QRect> lines = m_textRegions.detect(screenshot);
+        if (lines.size() <= m_config.ocrLineMaxRegions) {
+            if (tracing()) log(QString("[%1] 候选文本行 %2 个，逐行识别").arg(langCode).arg(lines.size()), LogLevel::Debug);
+            // 各行由线程池任务各自租用引擎，先归还当前实例
+            lease.release();
+            hits = recognizeLines(screenshot, langCode, lines, cancel, &cancelled);
+            if (cancelled && cancelledOut) *cancelledOut = true;
+            return hits;
+        }
+        log(QString("[%1] 候选文本行 %2 个超过上限，改用整页识别").arg(langCode).arg(lines.size()));
+    }
+    if (hits.isEmpty()) {
+        hits = recognizeKeywords(api, screenshot, QRect(), langCode, fullTextOut, cancel, &cancelled);
+        if (cancelled && cancelledOut) *cancelledOut = true;
+    }
+    // 引擎随 lease 析构 Clear() 后归还池中，不再 End()
+    return hits;
+}
+
+QVector<OcrHit> Detector::findKeywordsInRegions(const Frame &screenshot, const QString &langCode,
+                                                const QVector<QRect> &regions, const CancelFn &cancel, bool *cancelledOut)
+{
+    bool cancelled = false;
+    if (cancelledOut) *cancelledOut = false;
+    if (cancel && cancel()) {
+        if (cancelledOut) *cancelledOut = true;
+        return {};
+    }
+    StageTimer stage(Stage::OcrFind);
+    OcrEnginePool::Lease lease = m_ocrPool.acquire(langCode);
+    if (!lease) {
+        log(QString("Tesseract初始化失败(%1)" ).arg(langCode), LogLevel::Warning);
+        return {};
+    }
+    tesseract::TessBaseAPI &api = *lease.api();
+    api.SetVariable("user_defined_dpi", "96");
+
+    QVector<OcrHit> hits;
+    for (const QRect &r : regions) {
+        const QRect clipped = r.intersected(screenshot.rect());
+        if (clipped.isEmpty()) continue;
+        if (tracing())
+            log(QString("[%1] 区域识别: (%2,%3,%4,%5)").arg(langCode)
+                .arg(clipped.x()).arg(clipped.y()).arg(clipped.width()).arg(clipped.height()), LogLevel::Debug);
+        hits += recognizeKeywords(api, screenshot, clipped, langCode, nullptr, cancel, &cancelled);
+        if (cancelled) {
+            if (cancelledOut) *cancelledOut = true;
+            return {};
+        }
+        api.Clear();
+    }
+    return hits;
+}
+
+QRect Detector::runOcrFindWithLang(const Frame &screenshot, const QString &langCode, QString *recognizedOut, const QRect &roi)
+{
+    const QVector<OcrHit> hits = findKeywords(screenshot, langCode, roi, recognizedOut);
+    const OcrHit *hit = bestHit(hits, primaryKeyword());
+    return hit ? hit->rect : QRect();
+}
+
+OcrResult Detector::runOcr(const Frame &screenshot, const QString &langCode, const QRect &roi, bool wantFullText,
+                           const CancelFn &cancel)
+{
+    OcrResult r;
+    r.lang = langCode;
+    QString fullText;
+    r.hits = findKeywords(screenshot, langCode, roi, wantFullText ? &fullText : nullptr, cancel, &r.cancelled);
+    if (const OcrHit *hit = bestHit(r.hits, primaryKeyword())) r.rect = hit->rect;
+    r.text = wantFullText ? fullText : describeHits(r.hits);
+    return r;
+}
+
+QString Detector::describeHits(const QVector<OcrHit> &hits)
+{
+    QStringList parts;
+    for (const OcrHit &h : hits) parts << QString("%1(%2)").arg(h.keyword).arg(h.confidence, 0, 'f', 0);
+    return parts.join(' ');
+}
+
+const OcrHit *Detector::bestHit(const QVector<OcrHit> &hits, const QString &keyword)
+{
+    const OcrHit *best = nullptr;
+    for (const OcrHit &h : hits) {
+        if (h.keyword == keyword && (!best || h.confidence > best->confidence)) best = &h;
+    }
+    return best;
+}
+
+QRect Detector::expandOcrRoi(const QRect &r, const QSize &bounds) const
+{
+    const int padX = qMax(m_config.ocrRoiMinPad, (int)(r.width() * m_config.ocrRoiMargin));
+    const int padY = qMax(m_config.ocrRoiMinPad, (int)(r.height() * m_config.ocrRoiMargin));
+    return r.adjusted(-padX, -padY, padX, padY).intersected(QRect(QPoint(0, 0), bounds));
+}
+
+QVector<OcrHit> Detector::recognizeKeywords(tesseract::TessBaseAPI &api, const Frame &screenshot, const QRect &region,
+                                            const QString &langCode, QString *fullTextOut, const CancelFn &cancel,
+                                            bool *cancelledOut)
+{
+    *cancelledOut = false;
+    // 全图需要版面分析；ROI 内基本只有标签本身，按单一文本块识别
+    const bool fullPage = region.isEmpty();
+    // 全图取帧缓存的灰度平面（行检测、其他语言变体共用）；ROI 只转换区域内像素
+    Pix *pix = fullPage ? ImageConvert::grayToPix(screenshot.gray())
+                        : ImageConvert::toGrayPix(screenshot.image(), region);
+    if (!pix) return {};
+    return recognizePix(api, pix, fullPage ? tesseract::PSM_AUTO : tesseract::PSM_SINGLE_BLOCK,
+                        fullPage ? QPoint(0, 0) : region.topLeft(), 1.0, langCode, fullTextOut, cancel, cancelledOut);
+}
+
+QVector<OcrHit> Detector::recognizeLines(const Frame &screenshot, const QString &langCode, const QVector<QRect> &lines,
+                                         const CancelFn &cancel, bool *cancelledOut)
+{
+    *cancelledOut = false;
+    std::atomic<bool> cancelled{false};
+    const int lineHeight = m_config.ocrLineHeight;
+    // 各任务共用帧的灰度平面，只在这里转换一次
+    const cv::Mat &gray = screenshot.gray();
+    auto recognizeLine = [this, &gray, &langCode, &cancel, &cancelled, lineHeight](const QRect &line) {
+        if (cancelled || (cancel && cancel())) {
+            cancelled = true;
+            return QVector<OcrHit>();
+        }
+        OcrEnginePool::Lease lease = m_ocrPool.acquire(langCode);
+        if (!lease) return QVector<OcrHit>();
+        tesseract::TessBaseAPI &api = *lease.api();
+        api.SetVariable("user_defined_dpi", "96");
+        double scale = 1.0;
+        Pix *pix = ImageConvert::toLinePix(gray, line, lineHeight, &scale);
+        if (!pix) return QVector<OcrHit>();
+        bool lineCancelled = false;
+        QVector<OcrHit> hits = recognizePix(api, pix, tesseract::PSM_SINGLE_LINE, line.topLeft(), scale, langCode,
+                                            nullptr, cancel, &lineCancelled);
+        if (lineCancelled) cancelled = true;
+        return hits;
+    };
+
+    // 第一行在当前线程识别，其余交给线程池
+    QVector<QFuture<QVector<OcrHit>>> futures;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QRect line = lines[i];
+        futures << QtConcurrent::run([recognizeLine, line]() { return recognizeLine(line); });
+    }
+    QVector<OcrHit> hits;
+    if (!lines.isEmpty()) hits = recognizeLine(lines.first());
+    for (QFuture<QVector<OcrHit>> &f : futures) hits += f.result();
+    if (cancelled) {
+        *cancelledOut = true;
+        return {};
+    }
+    return hits;
+}
+
+QVector<OcrHit> Detector::recognizePix(tesseract::TessBaseAPI &api, Pix *pix, int pageSegMode, const QPoint &offset,
+                                       double scale, const QString &langCode, QString *fullTextOut,
+                                       const CancelFn &cancel, bool *cancelledOut)
+{
+    *cancelledOut = false;
+    api.SetPageSegMode(tesseract::PageSegMode(pageSegMode));
+    api.SetImage(pix);
+    {
+        StageTimer recognize(Stage::OcrRecognize);
+        tesseract::ETEXT_DESC monitor;
+        if (cancel) {
+            monitor.cancel = &cancelRecognition;
+            monitor.cancel_this = const_cast<CancelFn *>(&cancel);
+        }
+        api.Recognize(cancel ? &monitor : nullptr);
+    }
+    if (cancel && cancel()) {
+        // 中止后的结果不完整，直接丢弃
+        log(QString("[%1] 识别已取消").arg(langCode));
+        pixDestroy(&pix);
+        *cancelledOut = true;
+        return {};
+    }
+    // 全文只在调用方需要时才拼装
+    if (fullTextOut) {
+        char *outText = api.GetUTF8Text();
+        *fullTextOut = QString::fromUtf8(outText ? outText : "").simplified();
+        delete [] outText;
+        log(QString("[%1] OCR全文:%2").arg(langCode, fullTextOut->left(80)));
+    }
+
+    StageTimer iterate(Stage::OcrIterate);
+    QVector<OcrHit> hits;
+    if (!m_keywords.isEmpty()) {
+        // 单次字符级遍历，逐字符喂给自动机；环形缓冲保存最近 maxLength 个字符的框与置信度，
+        // 命中时合并关键词覆盖的字符框。关键词不跨文本行。
+        struct Glyph { QRect box; float conf; };
+        const int window = m_keywords.maxLength();
+        QVector<Glyph> ring(window);
+        qint64 pos = 0;
+        int state = KeywordMatcher::rootState();
+
+        tesseract::ResultIterator *ri = api.GetIterator();
+        const tesseract::PageIteratorLevel level = tesseract::RIL_SYMBOL;
+        if (ri) {
+            do {
+                if (ri->IsAtBeginningOf(tesseract::RIL_TEXTLINE)) state = KeywordMatcher::rootState();
+                const char *sym = ri->GetUTF8Text(level);
+                const QString s = QString::fromUtf8(sym ? sym : "").trimmed();
+                delete [] sym;
+                if (s.isEmpty()) continue;
+                const float conf = ri->Confidence(level);
+                int x1, y1, x2, y2;
+                ri->BoundingBox(level, &x1, &y1, &x2, &y2);
+                // 放大识别的行按比例换回原图坐标
+                const QRect box(QPoint(int(x1 / scale), int(y1 / scale)), QPoint(int(x2 / scale), int(y2 / scale)));
+                for (QChar c : s) {
+                    ring[pos % window] = Glyph{box, conf};
+                    state = m_keywords.step(state, c);
+                    for (int k : m_keywords.hitsAt(state)) {
+                        const int len = m_keywords.keywords().at(k).size();
+                        OcrHit hit;
+                        hit.keyword = m_keywords.keywords().at(k);
+                        // 合并框；置信度取最弱的字符
+                        hit.confidence = 100.0f;
+                        for (int i = 0; i < len; ++i) {
+                            const Glyph &g = ring[(pos - i) % window];
+                            hit.rect = hit.rect.united(g.box);
+                            hit.confidence = qMin(hit.confidence, g.conf);
+                        }
+                        hit.rect.translate(offset);
+                        hits << hit;
+                    }
+                    ++pos;
+                }
+                if (tracing())
+                    log(QString("[%1] 字:'%2' conf=%3 box=(%4,%5,%6,%7)")
+                        .arg(langCode, s).arg(conf, 0, 'f', 1).arg(x1).arg(y1).arg(x2).arg(y2), LogLevel::Debug);
+            } while (ri->Next(level));
+            delete ri;
+        }
+    }
+    pixDestroy(&pix);
+
+    for (const OcrHit &h : hits) {
+        log(QString("[%1] 命中'%2' conf=%3 box=(%4,%5,%6,%7)").arg(langCode, h.keyword).arg(h.confidence, 0, 'f', 1)
+            .arg(h.rect.x()).arg(h.rect.y()).arg(h.rect.width()).arg(h.rect.height()));
+    }
+    return hits;
+}
@@ -0,0 +1,120 @@
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+struct Pix;
+
+#include "appconfig.h"
+#include "frame.h"
+#include "keywordmatcher.h"
+#include "logsink.h"
+#include "ocrenginepool.h"
+#include "templatematcher.h"
+#include "templateregistry.h"
+#include "tessdatacatalog.h"
+#include "tessmodelregistry.h"
+#include "textregions.h"
+
+// cancelled 为 true 时匹配被中途取消，结果无效
+struct TemplateResult { QPoint pt; double score; QSize size; double scale = 1.0; bool cancelled = false; };
+// 一个关键词命中：框为各字符框的并集（全图坐标），置信度取其中最低的字符
+struct OcrHit { QString keyword; QRect rect; float confidence = 0.0f; };
+struct OcrResult { QRect rect; QString text; QString lang; QVector<OcrHit> hits; bool cancelled = false; };
+
+// 识别核心：模板匹配与“魂兽幻境”OCR，不依赖界面，供 GUI、CLI 与基准共用。
+// 所有 run* 方法可在多个线程中并发调用。
+class Detector
+{
+public:
+    using LogFn = ::LogFn;
+    // 识别过程中周期性调用，返回 true 时中止（经由 Tesseract 的 ETEXT_DESC::cancel）
+    using CancelFn = std::function<bool()>;
+
+    explicit Detector(const AppConfig &config = AppConfig(), LogFn log = LogFn());
+    ~Detector();
+
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+    // 需在识别开始前调用
+    void setConfig(const AppConfig &config);
+    const AppConfig &config() const { return m_config; }
+
+    // 后台预热 OCR 引擎
+    void warmUp(const QStringList &langCodes, int perLang = 1) { m_ocrPool.warmUp(langCodes, perLang); }
+    void waitForWarmUp() { m_ocrPool.waitForWarmUp(); }
+
+    // cancel 在尺度 / 候选之间检查，返回 true 后跳过尚未开始的尺度，返回 (-1,-1) 并置 cancelledOut
+    QPoint runTemplateMatch(const Frame &screenshot, double &scoreOut,
+                            TemplateMatcher::Mode mode = TemplateMatcher::Mode::Exhaustive,
+                            QSize *sizeOut = nullptr, double *scaleOut = nullptr,
+                            const CancelFn &cancel = CancelFn(), bool *cancelledOut = nullptr);
+    // 只在 window 内、scale 及其相邻尺度上匹配，只转换窗口内的像素；未匹配返回 (-1,-1)
+    TemplateResult runTemplateMatchNear(const Frame &screenshot, const QRect &window, double scale, int levelRadius = 1);
+    // 一次识别找出配置中的全部关键词；roi 有效时先只识别该区域（全图坐标），主关键词未命中再回退全图。
+    // fullTextOut 非空时才额外拼装识别全文；被 cancel 中止时返回空并置 cancelledOut
+    QVector<OcrHit> findKeywords(const Frame &screenshot, const QString &langCode, const QRect &roi = QRect(),
+                                 QString *fullTextOut = nullptr, const CancelFn &cancel = CancelFn(),
+                                 bool *cancelledOut = nullptr);
+    // 依次识别各区域（全图坐标），不回退全图；用于只重新识别画面变化的部分
+    QVector<OcrHit> findKeywordsInRegions(const Frame &screenshot, const QString &langCode, const QVector<QRect> &regions,
+                                          const CancelFn &cancel = CancelFn(), bool *cancelledOut = nullptr);
+    // 只返回主关键词（配置列表第一项）置信度最高的框
+    QRect runOcrFindWithLang(const Frame &screenshot, const QString &langCode, QString *recognizedOut = nullptr,
+                             const QRect &roi = QRect());
+    // 整理为 OcrResult：rect 为主关键词位置，text 为命中列表，wantFullText 时改为识别全文
+    OcrResult runOcr(const Frame &screenshot, const QString &langCode, const QRect &roi = QRect(),
+                     bool wantFullText = false, const CancelFn &cancel = CancelFn());
+    QString primaryKeyword() const { return m_keywords.keywords().value(0); }
+    // 形如 "魂兽幻境(91) 副本(85)"
+    static QString describeHits(const QVector<OcrHit> &hits);
+    static const OcrHit *bestHit(const QVector<OcrHit> &hits, const QString &keyword);
+    QRect expandOcrRoi(const QRect &r, const QSize &bounds) const;
+
+    TemplateRegistry &templates() { return m_templates; }
+    TemplateMatcher &matcher() { return m_matcher; }
+    OcrEnginePool &ocrPool() { return m_ocrPool; }
+    TessdataCatalog &tessdata() { return m_catalog; }
+    const TextRegionDetector &textRegions() const { return m_textRegions; }
+
+private:
+    // 查找语言变体对应的 traineddata 文件与传给 Init 的语言名
+    bool resolveTessdata(const QString &langCode, TessdataCatalog::Entry *model, QString *langParam);
+    // region 为空时整图 PSM_AUTO，否则只识别该区域，返回框均为全图坐标
+    QVector<OcrHit> recognizeKeywords(tesseract::TessBaseAPI &api, const Frame &screenshot, const QRect &region,
+                                      const QString &langCode, QString *fullTextOut, const CancelFn &cancel,
+                                      bool *cancelledOut);
+    // 识别已转换好的 pix（接管并释放）；pix 坐标乘以 1/scale 再加 offset 得到全图坐标
+    QVector<OcrHit> recognizePix(tesseract::TessBaseAPI &api, Pix *pix, int pageSegMode, const QPoint &offset,
+                                 double scale, const QString &langCode, QString *fullTextOut, const CancelFn &cancel,
+                                 bool *cancelledOut);
+    // 各候选行按 PSM_SINGLE_LINE 在全局线程池中并行识别，每个任务各自租用引擎
+    QVector<OcrHit> recognizeLines(const Frame &screenshot, const QString &langCode, const QVector<QRect> &lines,
+                                   const CancelFn &cancel, bool *cancelledOut);
+    // 调试级追踪开启时才值得格式化消息
+    bool tracing() const { return m_log && LogSink::enabled(LogLevel::Debug); }
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    AppConfig m_config;
+    KeywordMatcher m_keywords;
+    LogFn m_log;
+    // 多尺度模板缓存，仅在模板文件变化时重建
+    TemplateRegistry m_templates;
+    TemplateMatcher m_matcher;
+    // 启动时扫描的 tessdata 模型目录，查找时不访问文件系统
+    TessdataCatalog m_catalog;
+    // 已映射的 traineddata，多个引擎共用同一映射
+    TessModelRegistry m_models;
+    // 预热并复用的 Tesseract 引擎池
+    OcrEnginePool m_ocrPool;
+    // 行识别模式下的候选文本行检测
+    TextRegionDetector m_textRegions;
+};
+
+#endif // DETECTOR_H
@@ -0,0 +1,176 @@
+#include "detectpipeline.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+DetectPipeline::DetectPipeline(std::unique_ptr<FrameSource> source, const Options &options, LogFn log)
+    : m_source(std::move(source)), m_opt(options), m_log(std::move(log))
+{
+}
+
+DetectPipeline::~DetectPipeline()
+{
+    stop();
+}
+
+void DetectPipeline::start()
+{
+    if (m_running.load() || !m_source) return;
+    stop();
+    m_preSlot.reset();
+    m_templateSlot.reset();
+    m_ocrSlot.reset();
+    m_stopRequested = false;
+    m_running = true;
+    m_clock.start();
+
+    m_threads << QThread::create([this]() { captureLoop(); threadExited(); });
+    m_threads << QThread::create([this]() { preprocessLoop(); threadExited(); });
+    if (m_templateStage)
+        m_threads << QThread::create([this]() { stageLoop(m_templateSlot, m_templateStage, m_templateRuns); threadExited(); });
+    if (m_ocrStage)
+        m_threads << QThread::create([this]() { stageLoop(m_ocrSlot, m_ocrStage, m_ocrRuns); threadExited(); });
+
+    m_liveThreads = m_threads.size();
+    static const char *names[] = { "pipe-capture", "pipe-preprocess", "pipe-stage", "pipe-stage" };
+    for (int i = 0; i < m_threads.size(); ++i) {
+        m_threads[i]->setObjectName(names[qMin(i, 3)]);
+        m_threads[i]->start();
+    }
+    log(QString("[管线] 启动: 来源=%1 fps=%2 变化检测=%3")
+        .arg(m_source->name()).arg(m_opt.fps).arg(m_opt.gating ? "开" : "关"));
+}
+
+void DetectPipeline::stop()
+{
+    if (m_threads.isEmpty()) return;
+    {
+        QMutexLocker lock(&m_sleepMutex);
+        m_stopRequested = true;
+        m_sleepCond.wakeAll();
+    }
+    // 主动停止时丢弃尚未处理的帧，只等待正在执行的阶段结束
+    m_preSlot.close(true);
+    m_templateSlot.close(true);
+    m_ocrSlot.close(true);
+    for (QThread *t : m_threads) {
+        t->wait();
+        delete t;
+    }
+    m_threads.clear();
+    if (m_running.exchange(false)) m_elapsedNs = m_clock.nsecsElapsed();
+    log(QString("[管线] 已停止: %1 %2").arg(statsSummary(), m_framePool->summary()));
+}
+
+bool DetectPipeline::sleepNs(qint64 ns)
+{
+    QMutexLocker lock(&m_sleepMutex);
+    if (m_stopRequested) return false;
+    if (ns > 0) m_sleepCond.wait(&m_sleepMutex, (unsigned long)qMax<qint64>(1, ns / 1000000));
+    return !m_stopRequested;
+}
+
+void DetectPipeline::threadExited()
+{
+    if (--m_liveThreads > 0) return;
+    // 最后一个线程退出：来源自然结束时通知调用方
+    if (!m_stopRequested) {
+        m_elapsedNs = m_clock.nsecsElapsed();
+        m_running = false;
+        log(QString("[管线] 来源播放完毕: %1 %2").arg(statsSummary(), m_framePool->summary()));
+        if (m_onFinished) m_onFinished();
+    }
+}
+
+namespace {
+// 截图失败后的重试间隔
+constexpr qint64 kGrabRetryNs = 100 * 1000000LL;
+} // namespace
+
+void DetectPipeline::captureLoop()
+{
+    const qint64 intervalNs = m_opt.fps > 0 ? qint64(1e9 / m_opt.fps) : 0;
+    qint64 seq = 0;
+    qint64 nextNs = m_clock.nsecsElapsed();
+    while (!m_stopRequested) {
+        QImage img = m_source->grab();
+        if (img.isNull()) {
+            if (m_source->atEnd()) break;
+            // 目标窗口关闭或最小化时截图会持续失败：无论帧率多少都退避一段时间，避免空转占满一个核
+            if (!sleepNs(kGrabRetryNs)) break;
+            nextNs = m_clock.nsecsElapsed();
+            continue;
+        } else {
+            PipelineFrame f;
+            f.seq = ++seq;
+            f.captureMs = m_clock.elapsed();
+            f.frame = Frame(img, m_framePool);
+            m_captured++;
+            if (m_preSlot.put(std::move(f))) m_droppedPre++;
+        }
+        if (intervalNs > 0) {
+            nextNs += intervalNs;
+            const qint64 now = m_clock.nsecsElapsed();
+            // 落后超过一帧时不补帧，从当前时刻重新计时
+            if (nextNs < now) nextNs = now;
+            if (!sleepNs(nextNs - now)) break;
+        }
+    }
+    m_preSlot.close(false);
+}
+
+void DetectPipeline::preprocessLoop()
+{
+    TileHasher hasher(m_opt.diffDownscale, m_opt.diffTilePx);
+    TileHasher::Grid prev;
+    PipelineFrame f;
+    while (m_preSlot.take(f)) {
+        TileHasher::Grid grid = hasher.compute(f.frame);
+        f.change = TileHasher::diff(prev, grid);
+        prev = grid;
+        if (m_opt.gating && f.change.changed < m_opt.minChangedTiles) {
+            m_unchanged++;
+            continue;
+        }
+        m_processed++;
+        if (m_onFrame) m_onFrame(f);
+        if (m_templateStage && m_templateSlot.put(f)) m_droppedTemplate++;
+        if (m_ocrStage && m_ocrSlot.put(f)) m_droppedOcr++;
+    }
+    m_templateSlot.close(false);
+    m_ocrSlot.close(false);
+}
+
+void DetectPipeline::stageLoop(LatestSlot<PipelineFrame> &slot, const StageFn &fn, std::atomic<qint64> &runs)
+{
+    PipelineFrame f;
+    while (slot.take(f)) {
+        fn(f);
+        runs++;
+    }
+}
+
+DetectPipeline::Stats DetectPipeline::stats() const
+{
+    Stats s;
+    s.captured = m_captured;
+    s.unchanged = m_unchanged;
+    s.processed = m_processed;
+    s.droppedPreprocess = m_droppedPre;
+    s.droppedTemplate = m_droppedTemplate;
+    s.droppedOcr = m_droppedOcr;
+    s.templateRuns = m_templateRuns;
+    s.ocrRuns = m_ocrRuns;
+    s.elapsedSec = (m_running ? m_clock.nsecsElapsed() : m_elapsedNs.load()) / 1e9;
+    return s;
+}
+
+QString DetectPipeline::statsSummary() const
+{
+    const Stats s = stats();
+    const double sec = s.elapsedSec > 0 ? s.elapsedSec : 1.0;
+    return QString("采集=%1(%2fps) 无变化跳过=%3 识别帧=%4 丢弃(预处理/模板/OCR)=%5/%6/%7 模板=%8次 OCR=%9次 用时=%10s")
+        .arg(s.captured).arg(s.captured / sec, 0, 'f', 1).arg(s.unchanged).arg(s.processed)
+        .arg(s.droppedPreprocess).arg(s.droppedTemplate).arg(s.droppedOcr)
+        .arg(s.templateRuns).arg(s.ocrRuns).arg(s.elapsedSec, 0, 'f', 1);
+}
@@ -0,0 +1,166 @@
+#ifndef DETECTPIPELINE_H
+#define DETECTPIPELINE_H
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+#include <QList>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "framesource.h"
+#include "logsink.h"
+#include "tilehash.h"
+
+class QThread;
+
+struct PipelineFrame
+{
+    qint64 seq = 0;
+    qint64 captureMs = 0;       // 相对管线启动的毫秒数
+    Frame frame;                // 各阶段共享同一帧及其派生平面
+    TileHasher::Diff change;    // 与上一帧相比变化的格子
+};
+
+// 只保留最新一项的单槽队列：生产者覆盖未被取走的旧帧，而不是排队
+template <typename T>
+class LatestSlot
+{
+public:
+    // 返回 true 表示覆盖（丢弃）了一个尚未消费的旧项
+    bool put(T value)
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_closed) return false;
+        const bool dropped = m_has;
+        m_item = std::move(value);
+        m_has = true;
+        m_cond.wakeOne();
+        return dropped;
+    }
+    // 阻塞直到有新项；关闭后返回 false（discard 关闭时不再交出剩余项）
+    bool take(T &out)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (!m_has && !m_closed) m_cond.wait(&m_mutex);
+        if (!m_has || m_discard) return false;
+        out = std::move(m_item);
+        m_item = T();
+        m_has = false;
+        return true;
+    }
+    void close(bool discard)
+    {
+        QMutexLocker lock(&m_mutex);
+        m_closed = true;
+        m_discard = m_discard || discard;
+        m_cond.wakeAll();
+    }
+    void reset()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_item = T();
+        m_has = m_closed = m_discard = false;
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    T m_item{};
+    bool m_has = false;
+    bool m_closed = false;
+    bool m_discard = false;
+};
+
+// 连续采集识别管线
+// 采集 -> 预处理（帧变化检测）-> 模板匹配 / OCR，每个阶段一个线程，
+// 阶段之间用 LatestSlot 连接，处理不过来时丢弃旧帧，始终只处理最新画面。
+class DetectPipeline
+{
+public:
+    using LogFn = ::LogFn;
+    using StageFn = std::function<void(const PipelineFrame &)>;
+
+    struct Options {
+        double fps = 5.0;           // 采集帧率，<=0 表示尽可能快
+        bool gating = true;         // 画面无变化时跳过识别
+        int minChangedTiles = 1;    // 至少多少个格子变化才视为画面变化
+        int diffDownscale = 8;
+        int diffTilePx = 8;
+    };
+
+    struct Stats {
+        qint64 captured = 0;
+        qint64 unchanged = 0;       // 因画面无变化跳过
+        qint64 processed = 0;       // 送入识别阶段的帧
+        qint64 droppedPreprocess = 0;
+        qint64 droppedTemplate = 0;
+        qint64 droppedOcr = 0;
+        qint64 templateRuns = 0;
+        qint64 ocrRuns = 0;
+        double elapsedSec = 0.0;
+    };
+
+    DetectPipeline(std::unique_ptr<FrameSource> source, const Options &options, LogFn log = LogFn());
+    ~DetectPipeline();
+
+    // 以下回调均在管线线程中调用，需在 start() 之前设置
+    void setFrameHandler(StageFn fn) { m_onFrame = std::move(fn); }
+    void setTemplateStage(StageFn fn) { m_templateStage = std::move(fn); }
+    void setOcrStage(StageFn fn) { m_ocrStage = std::move(fn); }
+    // 有限来源播放完且各阶段处理完毕后调用（stop() 主动停止时不调用）
+    void setFinishedHandler(std::function<void()> fn) { m_onFinished = std::move(fn); }
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_running.load(); }
+
+    Stats stats() const;
+    QString statsSummary() const;
+    QString sourceName() const { return m_source ? m_source->name() : QString(); }
+
+private:
+    void captureLoop();
+    void preprocessLoop();
+    void stageLoop(LatestSlot<PipelineFrame> &slot, const StageFn &fn, std::atomic<qint64> &runs);
+    bool sleepNs(qint64 ns);
+    void threadExited();
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    std::unique_ptr<FrameSource> m_source;
+    Options m_opt;
+    // 帧的灰度 / BGR / 缩小图缓冲，帧可能比管线活得久，故共享持有
+    std::shared_ptr<FramePool> m_framePool = std::make_shared<FramePool>();
+    LogFn m_log;
+    StageFn m_onFrame;
+    StageFn m_templateStage;
+    StageFn m_ocrStage;
+    std::function<void()> m_onFinished;
+
+    LatestSlot<PipelineFrame> m_preSlot;
+    LatestSlot<PipelineFrame> m_templateSlot;
+    LatestSlot<PipelineFrame> m_ocrSlot;
+
+    QList<QThread *> m_threads;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<int> m_liveThreads{0};
+    QMutex m_sleepMutex;
+    QWaitCondition m_sleepCond;
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_elapsedNs{0};
+
+    std::atomic<qint64> m_captured{0};
+    std::atomic<qint64> m_unchanged{0};
+    std::atomic<qint64> m_processed{0};
+    std::atomic<qint64> m_droppedPre{0};
+    std::atomic<qint64> m_droppedTemplate{0};
+    std::atomic<qint64> m_droppedOcr{0};
+    std::atomic<qint64> m_templateRuns{0};
+    std::atomic<qint64> m_ocrRuns{0};
+};
+
+#endif // DETECTPIPELINE_H
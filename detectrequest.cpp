@@ -0,0 +1,79 @@
+#include "detectrequest.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+DetectRequest::Response DetectRequest::run(Detector &detector, OcrCascade &cascade, const std::atomic<bool> *cancel) const
+{
+    QElapsedTimer timer; timer.start();
+    Response resp;
+    const AppConfig &config = detector.config();
+    const Frame img = frame;
+    const TemplateMatcher::Mode mode = matchMode;
+    const auto notify = onTemplate;
+    TemplateTracker *const track = tracker;
+    // 被新请求取代后，模板匹配在尺度 / 候选之间、OCR 在 Tesseract 回调中尽快停止
+    Detector::CancelFn cancelled;
+    if (cancel) cancelled = [cancel]() { return cancel->load(); };
+
+    ResultCache::Key key;
+    const QString tmplVariant = QString::number(int(matchMode));
+    const QString ocrVariant = OcrCascade::modeName(ocrMode);
+    if (cache) key = ResultCache::hash(frame);
+
+    // 缓存只提供候选位置：在该位置按原尺度匹配一次，得分够高才采用，避免把相近画面的结果当作本帧结果
+    TemplateResult cachedTmpl{QPoint(-1, -1), 0.0, QSize()};
+    if (cache && cache->lookupTemplate(key, tmplVariant, &cachedTmpl) && cachedTmpl.pt.x() >= 0) {
+        const QRect box = QRect(cachedTmpl.pt, cachedTmpl.size).adjusted(-2, -2, 2, 2);
+        const TemplateResult confirmed = detector.runTemplateMatchNear(frame, box, cachedTmpl.scale, 0);
+        if (confirmed.pt.x() >= 0 && confirmed.score >= config.trackMinScore) {
+            cachedTmpl = confirmed;
+            resp.templateCached = true;
+        }
+    }
+    QFuture<TemplateResult> tmplFuture;
+    if (resp.templateCached) {
+        if (notify) notify(cachedTmpl);
+    } else {
+        tmplFuture = QtConcurrent::run([&detector, img, mode, notify, track, cancelled]() {
+            TemplateResult r{QPoint(-1, -1), 0.0, QSize()};
+            if (track) r = track->process(img, mode, nullptr, cancelled);
+            else r.pt = detector.runTemplateMatch(img, r.score, mode, &r.size, &r.scale, cancelled, &r.cancelled);
+            if (notify && !r.cancelled) notify(r);
+            return r;
+        });
+    }
+    auto templateResult = [&]() { return resp.templateCached ? cachedTmpl : tmplFuture.result(); };
+
+    if (runOcr) {
+        QRect roi;
+        if (config.ocrRoiEnabled && lastOcrRect.isValid()) {
+            roi = detector.expandOcrRoi(lastOcrRect, frame.size());
+        } else if (config.ocrRoiEnabled) {
+            const TemplateResult r = templateResult();
+            if (r.pt.x() >= 0 && r.score >= config.ocrRoiMinScore && !r.size.isEmpty())
+                roi = detector.expandOcrRoi(QRect(r.pt, r.size), frame.size());
+        }
+        // OCR 只在有 ROI 时使用缓存，以该区域取哈希并作为键的一部分：区域内容变化、或换了区域都不会命中。
+        // 整帧哈希察觉不到小标签的出现，无 ROI 时不查也不存；未命中的结果也不复用，否则标签出现后仍报告未找到
+        const bool useOcrCache = cache && roi.isValid();
+        ResultCache::Key ocrKey;
+        if (useOcrCache) ocrKey = ResultCache::hash(frame, roi);
+        OcrResult cachedOcr;
+        if (useOcrCache && cache->lookupOcr(ocrKey, ocrVariant, &cachedOcr) && cachedOcr.rect.isValid()) {
+            resp.ocr.fast = resp.ocr.final = cachedOcr;
+            resp.ocr.fastAccepted = true;
+            resp.ocrRan = resp.ocrCached = true;
+            if (onFast) onFast(cachedOcr);
+        } else if (!(cancel && cancel->load())) {
+            resp.ocr = cascade.run(frame, roi, ocrMode, cancel, onFast);
+            resp.ocrRan = true;
+            if (useOcrCache && resp.ocr.final.rect.isValid()) cache->storeOcr(ocrKey, ocrVariant, resp.ocr.final);
+        }
+    }
+    // 模板匹配结束后才返回，调用方据此保证同一时间只有一次识别在占用 CPU
+    resp.tmpl = templateResult();
+    if (cache && !resp.templateCached && !resp.tmpl.cancelled) cache->storeTemplate(key, tmplVariant, resp.tmpl);
+    resp.totalMs = timer.nsecsElapsed() / 1e6;
+    return resp;
+}
@@ -0,0 +1,46 @@
+#ifndef DETECTREQUEST_H
+#define DETECTREQUEST_H
+
+#include <QRect>
+#include <atomic>
+#include <functional>
+
+#include "detector.h"
+#include "ocrcascade.h"
+#include "resultcache.h"
+#include "templatetracker.h"
+
+// 一次完整识别：模板匹配与 OCR 级联并行，界面“执行”按钮与命令行回放共用。
+// OCR 的 ROI 优先取上次命中位置，其次取本次模板匹配结果（需等待模板匹配）。
+struct DetectRequest
+{
+    // 模板匹配与 OCR 共用同一帧的派生平面；传入 QImage 时隐式构造
+    Frame frame;
+    TemplateMatcher::Mode matchMode = TemplateMatcher::Mode::Exhaustive;
+    OcrCascade::Mode ocrMode = OcrCascade::Mode::Cascade;
+    QRect lastOcrRect;              // 上次 OCR 命中（全图坐标），无则为空
+    bool runOcr = true;
+    // 非空时先按画面哈希查缓存，命中的部分不再识别
+    ResultCache *cache = nullptr;
+    // 非空时模板匹配经跟踪器进行（连续帧），否则每次全图搜索
+    TemplateTracker *tracker = nullptr;
+
+    // 在执行线程中调用
+    std::function<void(const TemplateResult &)> onTemplate;
+    std::function<void(const OcrResult &)> onFast;
+
+    struct Response {
+        TemplateResult tmpl{QPoint(-1, -1), 0.0, QSize()};
+        OcrCascade::Outcome ocr;
+        bool ocrRan = false;        // 被取消时 OCR 不会启动
+        bool templateCached = false;
+        bool ocrCached = false;     // ocr 为缓存结果，fast / final 相同
+        double totalMs = 0.0;
+    };
+
+    // 同步执行；cancel 置位后模板匹配跑完正在计算的尺度即停止（tmpl.cancelled 为 true），
+    // 尚未开始的 OCR 不再启动、进行中的 OCR 经 Tesseract 回调中止，随后返回
+    Response run(Detector &detector, OcrCascade &cascade, const std::atomic<bool> *cancel = nullptr) const;
+};
+
+#endif // DETECTREQUEST_H
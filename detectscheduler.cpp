@@ -0,0 +1,88 @@
+#include "detectscheduler.h"
+
+#include <QMutexLocker>
+#include <QThreadPool>
+
+DetectScheduler::DetectScheduler(QThreadPool *pool)
+    : m_pool(pool ? pool : QThreadPool::globalInstance())
+{
+}
+
+DetectScheduler::~DetectScheduler()
+{
+    cancelAll();
+    waitForIdle();
+}
+
+quint64 DetectScheduler::submit(Job job)
+{
+    QMutexLocker lock(&m_mutex);
+    const quint64 gen = ++m_generation;
+    m_stats.submitted++;
+    // 正在执行的任务已过期：协作式取消，由任务自行检查标志退出
+    if (m_runningCancel) m_runningCancel->store(true);
+    if (m_pending.job) m_stats.coalesced++;
+    m_pending = Pending{ gen, std::move(job) };
+    if (!m_running) startNextLocked();
+    return gen;
+}
+
+void DetectScheduler::startNextLocked()
+{
+    Pending p = std::move(m_pending);
+    m_pending = Pending();
+    auto cancel = std::make_shared<std::atomic<bool>>(false);
+    m_runningCancel = cancel;
+    m_running = true;
+    m_stats.started++;
+    m_pool->start([this, p, cancel]() {
+        Ticket t;
+        t.generation = p.generation;
+        t.cancel = cancel.get();
+        p.job(t);
+
+        QMutexLocker lock(&m_mutex);
+        if (cancel->load()) m_stats.cancelled++;
+        m_running = false;
+        m_runningCancel.reset();
+        // 执行期间到达的最新请求接着执行
+        if (m_pending.job) startNextLocked();
+        else m_idle.wakeAll();
+    });
+}
+
+bool DetectScheduler::acceptResult(quint64 generation)
+{
+    if (isCurrent(generation)) return true;
+    QMutexLocker lock(&m_mutex);
+    m_stats.staleDropped++;
+    return false;
+}
+
+void DetectScheduler::cancelAll()
+{
+    QMutexLocker lock(&m_mutex);
+    ++m_generation;
+    if (m_pending.job) m_stats.coalesced++;
+    m_pending = Pending();
+    if (m_runningCancel) m_runningCancel->store(true);
+}
+
+void DetectScheduler::waitForIdle()
+{
+    QMutexLocker lock(&m_mutex);
+    while (m_running) m_idle.wait(&m_mutex);
+}
+
+DetectScheduler::Stats DetectScheduler::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+QString DetectScheduler::statsSummary() const
+{
+    const Stats s = stats();
+    return QString("请求=%1 执行=%2 合并=%3 取消=%4 过期丢弃=%5")
+        .arg(s.submitted).arg(s.started).arg(s.coalesced).arg(s.cancelled).arg(s.staleDropped);
+}
@@ -0,0 +1,67 @@
+#ifndef DETECTSCHEDULER_H
+#define DETECTSCHEDULER_H
+
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QThreadPool;
+
+// “只做最新一次”的识别任务调度
+// 每次 submit 分配递增的代号（generation）：同一时间只执行一个任务，
+// 尚未开始的旧请求被新请求合并替换，正在执行的旧任务收到取消标志后尽快退出，
+// 结果回到界面线程时用 acceptResult 丢弃过期代号，CPU 只花在最新画面上。
+class DetectScheduler
+{
+public:
+    struct Ticket {
+        quint64 generation = 0;
+        const std::atomic<bool> *cancel = nullptr;   // 被新请求取代或 cancelAll 时置位
+        bool cancelled() const { return cancel && cancel->load(std::memory_order_relaxed); }
+    };
+    using Job = std::function<void(const Ticket &)>;
+
+    struct Stats {
+        qint64 submitted = 0;
+        qint64 started = 0;
+        qint64 coalesced = 0;       // 排队中被新请求替换、从未执行
+        qint64 cancelled = 0;       // 执行中被取代
+        qint64 staleDropped = 0;    // 过期代号的结果被丢弃
+    };
+
+    // pool 为空时使用全局线程池
+    explicit DetectScheduler(QThreadPool *pool = nullptr);
+    ~DetectScheduler();
+
+    // 返回本次请求的代号；任务在线程池中执行
+    quint64 submit(Job job);
+    // 仅当 generation 仍是最新代号时返回 true，否则计为过期丢弃（线程安全）
+    bool acceptResult(quint64 generation);
+    bool isCurrent(quint64 generation) const { return generation == m_generation.load(); }
+    quint64 generation() const { return m_generation.load(); }
+
+    // 丢弃排队请求并取消正在执行的任务
+    void cancelAll();
+    void waitForIdle();
+
+    Stats stats() const;
+    QString statsSummary() const;
+
+private:
+    struct Pending { quint64 generation = 0; Job job; };
+    void startNextLocked();
+
+    QThreadPool *m_pool;
+    mutable QMutex m_mutex;
+    QWaitCondition m_idle;
+    std::atomic<quint64> m_generation{0};
+    Pending m_pending;
+    bool m_running = false;
+    std::shared_ptr<std::atomic<bool>> m_runningCancel;
+    Stats m_stats;
+};
+
+#endif // DETECTSCHEDULER_H
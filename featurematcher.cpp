@@ -0,0 +1,122 @@
+#include "featurematcher.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+void FeatureMatcher::setParams(const Params &p)
+{
+    QMutexLocker lock(&m_mutex);
+    m_params = p;
+}
+
+FeatureMatcher::Params FeatureMatcher::params() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_params;
+}
+
+QString FeatureMatcher::kindName(Kind kind)
+{
+    return kind == Kind::Akaze ? QStringLiteral("akaze") : QStringLiteral("orb");
+}
+
+FeatureMatcher::Kind FeatureMatcher::parseKind(const QString &name)
+{
+    return name.trimmed().toLower() == "akaze" ? Kind::Akaze : Kind::Orb;
+}
+
+cv::Ptr<cv::Feature2D> FeatureMatcher::createDetector(const Params &p, bool forTemplate)
+{
+    if (p.kind == Kind::Akaze) return cv::AKAZE::create();
+    // 模板只有几十像素高，缩小边缘与描述子邻域，否则提不出足够的关键点
+    return cv::ORB::create(forTemplate ? 500 : p.maxFeatures, 1.2f, 8, 15, 0, 2, cv::ORB::HARRIS_SCORE, 15, 10);
+}
+
+std::shared_ptr<const FeatureMatcher::TemplateFeatures> FeatureMatcher::featuresFor(const TemplateRegistry::PyramidPtr &tmpl,
+                                                                                  const Params &p)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_features && m_features->source == tmpl && m_features->kind == p.kind) return m_features;
+
+    auto f = std::make_shared<TemplateFeatures>();
+    f->source = tmpl;
+    f->kind = p.kind;
+    // 取最大的一层，细节最多
+    const TemplateRegistry::Level *base = nullptr;
+    for (const TemplateRegistry::Level &lv : tmpl->levels) {
+        if (!base || lv.scale > base->scale) base = &lv;
+    }
+    if (base) {
+        f->baseScale = base->scale;
+        f->size = base->bgr.size();
+        cv::Mat gray;
+        cv::cvtColor(base->bgr, gray, cv::COLOR_BGR2GRAY);
+        createDetector(p, true)->detectAndCompute(gray, base->mask, f->keypoints, f->descriptors);
+    }
+    m_features = f;
+    return f;
+}
+
+FeatureMatcher::Estimate FeatureMatcher::estimate(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl)
+{
+    Estimate est;
+    if (!tmpl || tmpl->levels.empty() || src3.empty()) return est;
+    const Params p = params();
+    std::shared_ptr<const TemplateFeatures> tf = featuresFor(tmpl, p);
+    est.templateKeypoints = int(tf->keypoints.size());
+    if (est.templateKeypoints < p.minInliers) return est;
+
+    cv::Mat gray;
+    cv::cvtColor(src3, gray, cv::COLOR_BGR2GRAY);
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    createDetector(p, false)->detectAndCompute(gray, cv::noArray(), keypoints, descriptors);
+    if (int(keypoints.size()) < p.minInliers) return est;
+
+    // ORB 与 AKAZE（MLDB）均为二进制描述子
+    cv::BFMatcher matcher(cv::NORM_HAMMING);
+    std::vector<std::vector<cv::DMatch>> knn;
+    matcher.knnMatch(tf->descriptors, descriptors, knn, 2);
+    std::vector<cv::Point2f> from, to;
+    for (const auto &m : knn) {
+        if (m.size() == 2 && m[0].distance < p.ratio * m[1].distance) {
+            from.push_back(tf->keypoints[m[0].queryIdx].pt);
+            to.push_back(keypoints[m[0].trainIdx].pt);
+        }
+    }
+    est.matches = int(from.size());
+    if (est.matches < p.minInliers) return est;
+
+    std::vector<uchar> inlierMask;
+    const cv::Mat h = cv::findHomography(from, to, cv::RANSAC, p.ransacPx, inlierMask);
+    if (h.empty()) return est;
+    est.inliers = int(std::count(inlierMask.begin(), inlierMask.end(), uchar(1)));
+    if (est.inliers < p.minInliers) return est;
+
+    // 由仿射部分求尺度与旋转；行列式非正说明发生了翻转，不是有效的匹配
+    const double a = h.at<double>(0, 0), b = h.at<double>(0, 1), c = h.at<double>(1, 0), d = h.at<double>(1, 1);
+    const double det = a * d - b * c;
+    if (det <= 0) return est;
+    est.scale = tf->baseScale * std::sqrt(det);
+    est.angleDeg = std::atan2(c, a) * 180.0 / CV_PI;
+    double minScale = tf->baseScale, maxScale = tf->baseScale;
+    for (const TemplateRegistry::Level &lv : tmpl->levels) {
+        minScale = std::min(minScale, lv.scale);
+        maxScale = std::max(maxScale, lv.scale);
+    }
+    if (est.scale < minScale / 2 || est.scale > maxScale * 2) return est;
+
+    const std::vector<cv::Point2f> corners = {
+        {0.0f, 0.0f}, {float(tf->size.width), 0.0f},
+        {float(tf->size.width), float(tf->size.height)}, {0.0f, float(tf->size.height)}
+    };
+    std::vector<cv::Point2f> projected;
+    cv::perspectiveTransform(corners, projected, h);
+    est.box = cv::boundingRect(projected) & cv::Rect(0, 0, src3.cols, src3.rows);
+    est.found = !est.box.empty();
+    return est;
+}
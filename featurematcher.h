@@ -0,0 +1,69 @@
+#ifndef FEATUREMATCHER_H
+#define FEATUREMATCHER_H
+
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+
+#include "templateregistry.h"
+
+// 特征点匹配
+// 每个模板只提取一次 ORB / AKAZE 关键点与描述子；截图提取一次后做 KNN 匹配 + 比值检验，
+// RANSAC 估计单应矩阵，一次得到位置、尺度与旋转，不随尺度数增加耗时。
+class FeatureMatcher
+{
+public:
+    enum class Kind { Orb, Akaze };
+
+    struct Params {
+        Kind kind = Kind::Orb;
+        int maxFeatures = 1500;     // 截图上最多保留的关键点（ORB）
+        double ratio = 0.75;        // Lowe 比值检验
+        int minInliers = 8;
+        double ransacPx = 4.0;      // RANSAC 重投影误差
+    };
+
+    struct Estimate {
+        bool found = false;
+        cv::Rect box;               // 模板四角投影后的外接矩形（截图坐标）
+        double scale = 1.0;         // 相对原始模板
+        double angleDeg = 0.0;
+        int templateKeypoints = 0;
+        int matches = 0;            // 通过比值检验的匹配
+        int inliers = 0;
+    };
+
+    FeatureMatcher() = default;
+
+    void setParams(const Params &p);
+    Params params() const;
+
+    // src3 为 BGR 截图；尺度超出 [minScale/2, maxScale*2] 的估计视为失败
+    Estimate estimate(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl);
+
+    static QString kindName(Kind kind);
+    static Kind parseKind(const QString &name);
+
+private:
+    struct TemplateFeatures {
+        TemplateRegistry::PyramidPtr source;
+        Kind kind = Kind::Orb;
+        double baseScale = 1.0;     // 提取特征所用的金字塔层
+        cv::Size size;
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+    };
+    // 模板金字塔或特征类型变化时重建
+    std::shared_ptr<const TemplateFeatures> featuresFor(const TemplateRegistry::PyramidPtr &tmpl, const Params &p);
+    static cv::Ptr<cv::Feature2D> createDetector(const Params &p, bool forTemplate);
+
+    mutable QMutex m_mutex;
+    Params m_params;
+    std::shared_ptr<const TemplateFeatures> m_features;
+};
+
+#endif // FEATUREMATCHER_H
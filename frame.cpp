@@ -0,0 +1,144 @@
+#include "frame.h"
+
+#include <QMutexLocker>
+#include <opencv2/imgproc.hpp>
+
+#include "imageconvert.h"
+#include "stagemetrics.h"
+
+cv::Mat FramePool::acquire(int rows, int cols, int type)
+{
+    QMutexLocker lock(&m_mutex);
+    for (cv::Mat &m : m_buffers) {
+        // 引用计数为 1 说明只剩池本身持有
+        if (m.rows == rows && m.cols == cols && m.type() == type && m.u && m.u->refcount == 1) {
+            m_reuses++;
+            return m;
+        }
+    }
+    cv::Mat m(rows, cols, type);
+    m_allocations++;
+    // 池满时淘汰已空闲的旧缓冲，仍被占用的不动
+    if (int(m_buffers.size()) >= m_maxBuffers) {
+        for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+            if (it->u && it->u->refcount == 1) {
+                m_buffers.erase(it);
+                break;
+            }
+        }
+    }
+    if (int(m_buffers.size()) < m_maxBuffers) m_buffers.push_back(m);
+    return m;
+}
+
+FramePool::Stats FramePool::stats() const
+{
+    Stats s;
+    s.allocations = m_allocations;
+    s.reuses = m_reuses;
+    QMutexLocker lock(&m_mutex);
+    for (const cv::Mat &m : m_buffers) s.bytes += qint64(m.total() * m.elemSize());
+    return s;
+}
+
+QString FramePool::summary() const
+{
+    const Stats s = stats();
+    return QString("帧缓冲池: 分配=%1 复用=%2 占用=%3MB")
+        .arg(s.allocations).arg(s.reuses).arg(s.bytes / 1048576.0, 0, 'f', 1);
+}
+
+struct Frame::Data
+{
+    QImage image;
+    std::shared_ptr<FramePool> pool;
+    // 每个平面各自加锁：并发的阶段请求同一平面时后到者等待，而不是重复计算
+    QMutex bgrMutex;
+    QMutex grayMutex;
+    QMutex smallMutex;
+    cv::Mat bgr;
+    cv::Mat gray;
+    QVector<QPair<int, cv::Mat>> small;
+
+    cv::Mat allocate(int rows, int cols, int type) const
+    {
+        return pool ? pool->acquire(rows, cols, type) : cv::Mat(rows, cols, type);
+    }
+};
+
+Frame::Frame(const QImage &image)
+    : Frame(image, nullptr)
+{
+}
+
+Frame::Frame(const QImage &image, std::shared_ptr<FramePool> pool)
+    : d(std::make_shared<Data>())
+{
+    d->image = image;
+    d->pool = std::move(pool);
+}
+
+const QImage &Frame::image() const
+{
+    static const QImage null;
+    return d ? d->image : null;
+}
+
+const cv::Mat &Frame::bgr() const
+{
+    static const cv::Mat empty;
+    if (!d || d->image.isNull()) return empty;
+    QMutexLocker lock(&d->bgrMutex);
+    if (d->bgr.empty()) {
+        // 预先分配好尺寸与类型，cvtColor 直接写入池中的缓冲
+        cv::Mat dst = d->allocate(d->image.height(), d->image.width(), CV_8UC3);
+        ImageConvert::toBgr(d->image, dst);
+        d->bgr = dst;
+    }
+    return d->bgr;
+}
+
+const cv::Mat &Frame::gray() const
+{
+    static const cv::Mat empty;
+    if (!d || d->image.isNull()) return empty;
+    QMutexLocker lock(&d->grayMutex);
+    if (d->gray.empty()) {
+        if (d->image.format() == QImage::Format_Grayscale8) {
+            // 灰度图直接包装，不拷贝
+            d->gray = cv::Mat(d->image.height(), d->image.width(), CV_8UC1,
+                              const_cast<uchar*>(d->image.constBits()), (size_t)d->image.bytesPerLine());
+        } else {
+            StageTimer stage(Stage::ConvertGrayPix);
+            cv::Mat dst = d->allocate(d->image.height(), d->image.width(), CV_8UC1);
+            QImage holder;
+            cv::cvtColor(ImageConvert::bgraView(d->image, &holder), dst, cv::COLOR_BGRA2GRAY);
+            d->gray = dst;
+        }
+    }
+    return d->gray;
+}
+
+cv::Mat Frame::graySmall(int factor) const
+{
+    if (!d || d->image.isNull()) return cv::Mat();
+    factor = qMax(1, factor);
+    if (factor == 1) return gray();
+    QMutexLocker lock(&d->smallMutex);
+    for (const auto &entry : d->small) {
+        if (entry.first == factor) return entry.second;
+    }
+    // 先缩小彩色图再转灰度，只处理 1/(factor^2) 的像素
+    const cv::Size sz(qMax(1, d->image.width() / factor), qMax(1, d->image.height() / factor));
+    QImage holder;
+    cv::Mat smallBgra;
+    cv::Mat dst = d->allocate(sz.height, sz.width, CV_8UC1);
+    if (d->image.format() == QImage::Format_Grayscale8) {
+        cv::resize(gray(), dst, sz, 0, 0, cv::INTER_AREA);
+    } else {
+        cv::resize(ImageConvert::bgraView(d->image, &holder), smallBgra, sz, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(smallBgra, dst, cv::COLOR_BGRA2GRAY);
+    }
+    d->small.append(qMakePair(factor, dst));
+    return dst;
+}
@@ -0,0 +1,72 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include <opencv2/core.hpp>
+
+// 派生平面的缓冲池
+// 保留一组 cv::Mat 缓冲，某块只剩池本身引用（持有它的帧都已释放）时即可交给下一帧，
+// 尺寸不变时稳态下每帧不再为灰度、BGR、缩小图分配内存。可在多个线程中并发使用。
+class FramePool
+{
+public:
+    struct Stats {
+        qint64 allocations = 0;
+        qint64 reuses = 0;
+        qint64 bytes = 0;           // 池中缓冲的总字节数
+    };
+
+    explicit FramePool(int maxBuffers = 16) : m_maxBuffers(maxBuffers) {}
+
+    // 返回一块 rows x cols、type 类型的缓冲，内容未初始化
+    cv::Mat acquire(int rows, int cols, int type);
+
+    Stats stats() const;
+    QString summary() const;
+
+private:
+    mutable QMutex m_mutex;
+    std::vector<cv::Mat> m_buffers;
+    int m_maxBuffers;
+    std::atomic<qint64> m_allocations{0};
+    std::atomic<qint64> m_reuses{0};
+};
+
+// 一帧截图及其派生平面
+// 复制 Frame 只增加引用计数，各阶段拿到的是同一帧的只读视图；
+// 灰度、BGR 与缩小灰度图在首次使用时计算一次，之后所有持有者共享。
+// 从 QImage 隐式构造，仍传 QImage 的调用方得到一个独立的帧（行为与以前相同）。
+class Frame
+{
+public:
+    Frame() = default;
+    Frame(const QImage &image);
+    Frame(const QImage &image, std::shared_ptr<FramePool> pool);
+
+    const QImage &image() const;
+    bool isNull() const { return image().isNull(); }
+    QSize size() const { return image().size(); }
+    int width() const { return image().width(); }
+    int height() const { return image().height(); }
+    QRect rect() const { return image().rect(); }
+
+    // 以下平面均为只读，调用方不得写入
+    const cv::Mat &bgr() const;     // CV_8UC3
+    const cv::Mat &gray() const;    // CV_8UC1
+    // 缩小 factor 倍（INTER_AREA）后的灰度图，按倍数缓存
+    cv::Mat graySmall(int factor) const;
+
+private:
+    struct Data;
+    std::shared_ptr<Data> d;
+};
+
+#endif // FRAME_H
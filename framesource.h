@@ -0,0 +1,35 @@
+#ifndef FRAMESOURCE_H
+#define FRAMESOURCE_H
+
+#include <QImage>
+#include <QString>
+#include <functional>
+
+// 帧来源：连续识别管线的采集阶段从这里取帧。
+// 窗口截图与图片序列见 capturesource.h
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+    // 取下一帧；暂时无帧或已结束时返回空图
+    virtual QImage grab() = 0;
+    // 有限来源（如图片目录）全部取完后返回 true
+    virtual bool atEnd() const { return false; }
+    virtual QString name() const = 0;
+};
+
+// 由回调提供帧
+class CallbackSource : public FrameSource
+{
+public:
+    CallbackSource(const QString &name, std::function<QImage()> fn)
+        : m_name(name), m_fn(std::move(fn)) {}
+    QImage grab() override { return m_fn ? m_fn() : QImage(); }
+    QString name() const override { return m_name; }
+
+private:
+    QString m_name;
+    std::function<QImage()> m_fn;
+};
+
+#endif // FRAMESOURCE_H
@@ -0,0 +1,25 @@
+#include "geometry.h"
+
+void mergeIntersectingRects(QVector<QRect> &rects, double minRowOverlap)
+{
+    auto shouldMerge = [minRowOverlap](const QRect &a, const QRect &b) {
+        if (!a.intersects(b)) return false;
+        if (minRowOverlap <= 0.0) return true;
+        const int overlap = qMin(a.bottom(), b.bottom()) - qMax(a.top(), b.top()) + 1;
+        return overlap >= minRowOverlap * qMin(a.height(), b.height());
+    };
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < rects.size() && !merged; ++i) {
+            for (int j = i + 1; j < rects.size(); ++j) {
+                if (shouldMerge(rects[i], rects[j])) {
+                    rects[i] |= rects[j];
+                    rects.removeAt(j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
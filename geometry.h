@@ -0,0 +1,12 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <QRect>
+#include <QVector>
+
+// 反复合并相交的矩形，直到两两不再相交。
+// minRowOverlap > 0 时还要求二者纵向重叠至少为较矮者高度的该比例（即同一行），
+// 上下相邻、只碰到边的矩形保持分开。
+void mergeIntersectingRects(QVector<QRect> &rects, double minRowOverlap = 0.0);
+
+#endif // GEOMETRY_H
@@ -0,0 +1,113 @@
+#include "imageconvert.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <leptonica/allheaders.h>
+
+#include "stagemetrics.h"
+
+namespace ImageConvert {
+
+namespace {
+
+bool isBgra32(QImage::Format f)
+{
+    return f == QImage::Format_ARGB32 || f == QImage::Format_RGB32
+        || f == QImage::Format_ARGB32_Premultiplied;
+}
+
+} // namespace
+
+cv::Mat bgraView(const QImage &img, QImage *holder)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    const QImage *src = &img;
+    if (!isBgra32(img.format())) {
+        *holder = img.convertToFormat(QImage::Format_ARGB32);
+        src = holder;
+    }
+#else
+    // 大端下 ARGB32 的内存顺序为 ARGB，改用 RGBA8888 再交换通道
+    *holder = img.convertToFormat(QImage::Format_RGBA8888).rgbSwapped();
+    const QImage *src = holder;
+#endif
+    // constBits() 不会触发隐式共享的深拷贝
+    return cv::Mat(src->height(), src->width(), CV_8UC4,
+                   const_cast<uchar*>(src->constBits()), (size_t)src->bytesPerLine());
+}
+
+void toBgr(const QImage &img, cv::Mat &dst, const QRect &roi)
+{
+    StageTimer stage(Stage::ConvertBgr);
+    const QRect r = roi.isNull() ? img.rect() : roi.intersected(img.rect());
+    const cv::Rect area(r.x(), r.y(), r.width(), r.height());
+    if (img.format() == QImage::Format_Grayscale8) {
+        cv::Mat gray(img.height(), img.width(), CV_8UC1,
+                     const_cast<uchar*>(img.constBits()), (size_t)img.bytesPerLine());
+        cv::cvtColor(gray(area), dst, cv::COLOR_GRAY2BGR);
+        return;
+    }
+    QImage holder;
+    cv::Mat bgra = bgraView(img, &holder);
+    cv::cvtColor(bgra(area), dst, cv::COLOR_BGRA2BGR);
+}
+
+Pix *toGrayPix(const QImage &img, const QRect &roi)
+{
+    StageTimer stage(Stage::ConvertGrayPix);
+    const QRect r = roi.isNull() ? img.rect() : roi.intersected(img.rect());
+    if (r.isEmpty()) return nullptr;
+
+    Pix *pix = pixCreateNoInit(r.width(), r.height(), 8);
+    if (!pix) return nullptr;
+    // Pix 每行按 32 位字对齐，直接作为 OpenCV 的目标缓冲区
+    cv::Mat dst(r.height(), r.width(), CV_8UC1, pixGetData(pix), (size_t)pixGetWpl(pix) * 4);
+
+    if (img.format() == QImage::Format_Grayscale8) {
+        cv::Mat gray(img.height(), img.width(), CV_8UC1,
+                     const_cast<uchar*>(img.constBits()), (size_t)img.bytesPerLine());
+        gray(cv::Rect(r.x(), r.y(), r.width(), r.height())).copyTo(dst);
+    } else {
+        QImage holder;
+        cv::Mat bgra = bgraView(img, &holder);
+        cv::cvtColor(bgra(cv::Rect(r.x(), r.y(), r.width(), r.height())), dst, cv::COLOR_BGRA2GRAY);
+    }
+    // Leptonica 以字内大端顺序存放 8 位像素，小端机器上需按字交换字节（大端下为空操作）
+    pixEndianByteSwap(pix);
+    return pix;
+}
+
+Pix *grayToPix(const cv::Mat &gray, const QRect &roi)
+{
+    const QRect r = roi.isNull() ? QRect(0, 0, gray.cols, gray.rows) : roi.intersected(QRect(0, 0, gray.cols, gray.rows));
+    if (r.isEmpty() || gray.type() != CV_8UC1) return nullptr;
+    Pix *pix = pixCreateNoInit(r.width(), r.height(), 8);
+    if (!pix) return nullptr;
+    cv::Mat dst(r.height(), r.width(), CV_8UC1, pixGetData(pix), (size_t)pixGetWpl(pix) * 4);
+    gray(cv::Rect(r.x(), r.y(), r.width(), r.height())).copyTo(dst);
+    pixEndianByteSwap(pix);
+    return pix;
+}
+
+Pix *toLinePix(const cv::Mat &gray, const QRect &roi, int targetHeight, double *scaleOut)
+{
+    *scaleOut = 1.0;
+    const QRect r = roi.intersected(QRect(0, 0, gray.cols, gray.rows));
+    if (r.isEmpty() || gray.type() != CV_8UC1) return nullptr;
+
+    const cv::Mat crop = gray(cv::Rect(r.x(), r.y(), r.width(), r.height()));
+    cv::Mat scaled, line;
+    const double scale = qBound(1.0, double(targetHeight) / r.height(), 4.0);
+    if (scale > 1.0) cv::resize(crop, scaled, cv::Size(), scale, scale, cv::INTER_CUBIC);
+    else scaled = crop;
+    // 灰度图为帧的共享平面，二值化写入新的缓冲
+    cv::threshold(scaled, line, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    // 浅色字在深色底上时反相：行内文字像素应占少数
+    if (cv::countNonZero(line) * 2 < int(line.total())) cv::bitwise_not(line, line);
+
+    Pix *pix = grayToPix(line);
+    if (pix) *scaleOut = scale;
+    return pix;
+}
+
+} // namespace ImageConvert
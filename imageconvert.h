@@ -0,0 +1,35 @@
+#ifndef IMAGECONVERT_H
+#define IMAGECONVERT_H
+
+#include <QImage>
+#include <QRect>
+
+#include <opencv2/core.hpp>
+
+struct Pix;
+
+// QImage 与 cv::Mat / Leptonica Pix 之间的转换
+// 32 位 QImage（ARGB32 系列）在小端内存中即 BGRA，可直接包装成 cv::Mat 而不拷贝；
+// 灰度转换整行交给 OpenCV 的向量化 cvtColor，直接写入 Pix 的字对齐行。
+namespace ImageConvert {
+
+// 以 CV_8UC4(BGRA) 视图包装 img 的像素，不拷贝；img 必须在 Mat 使用期间保持存活。
+// 非 32 位格式先转换到 holder 中再包装。
+cv::Mat bgraView(const QImage &img, QImage *holder);
+
+// 转换为 BGR，dst 尺寸匹配时复用其缓冲区；roi 有效时只转换该区域
+void toBgr(const QImage &img, cv::Mat &dst, const QRect &roi = QRect());
+
+// 生成 8 位灰度 Pix，roi 为空时转换整幅图像；调用方负责 pixDestroy
+Pix *toGrayPix(const QImage &img, const QRect &roi = QRect());
+
+// 由已有的 8 位灰度 Mat 生成 Pix（拷贝 roi 区域），roi 为空时拷贝整幅；调用方负责 pixDestroy
+Pix *grayToPix(const cv::Mat &gray, const QRect &roi = QRect());
+
+// 单行识别用：从灰度图裁剪 roi，行高不足 targetHeight 时放大（至多 4 倍），再二值化为白底黑字。
+// scaleOut 返回放大倍数；调用方负责 pixDestroy
+Pix *toLinePix(const cv::Mat &gray, const QRect &roi, int targetHeight, double *scaleOut);
+
+} // namespace ImageConvert
+
+#endif // IMAGECONVERT_H
@@ -0,0 +1,185 @@
+#include "incrementalocr.h"
+
+#include <QStringList>
+
+#include "geometry.h"
+
+IncrementalOcr::IncrementalOcr(Detector &detector, const QString &langCode, const TileHasher &hasher)
+    : m_detector(detector), m_lang(langCode), m_hasher(hasher)
+{
+    m_marginPx = qMax(m_marginPx, hasher.downscale() * hasher.tilePx());
+}
+
+void IncrementalOcr::reset()
+{
+    m_prev = TileHasher::Grid();
+    m_hits.clear();
+}
+
+QVector<QRect> IncrementalOcr::dirtyRegions(const TileHasher &hasher, const TileHasher::Grid &grid,
+                                            const TileHasher::Diff &diff, int marginPx)
+{
+    QVector<QRect> rects;
+    const int n = grid.cols * grid.rows;
+    if (n <= 0 || diff.dirty.size() != n) return rects;
+    const QRect frameRect(QPoint(0, 0), grid.frameSize);
+
+    // 4 邻接连通块，每块取外接矩形
+    QVector<bool> seen(n, false);
+    QVector<int> stack;
+    for (int start = 0; start < n; ++start) {
+        if (!diff.dirty[start] || seen[start]) continue;
+        QRect box;
+        stack.append(start);
+        seen[start] = true;
+        while (!stack.isEmpty()) {
+            const int i = stack.takeLast();
+            box |= hasher.tileRect(grid, i);
+            const int x = i % grid.cols, y = i / grid.cols;
+            const int neighbours[4][2] = { {x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1} };
+            for (const auto &nb : neighbours) {
+                if (nb[0] < 0 || nb[1] < 0 || nb[0] >= grid.cols || nb[1] >= grid.rows) continue;
+                const int j = nb[1] * grid.cols + nb[0];
+                if (diff.dirty[j] && !seen[j]) { seen[j] = true; stack.append(j); }
+            }
+        }
+        rects.append(box.adjusted(-marginPx, -marginPx, marginPx, marginPx).intersected(frameRect));
+    }
+
+    // 外扩后相交的矩形合并，直到稳定
+    mergeIntersectingRects(rects);
+    return rects;
+}
+
+IncrementalOcr::Result IncrementalOcr::process(const Frame &frame, const Detector::CancelFn &cancel)
+{
+    Result res;
+    const TileHasher::Grid grid = m_hasher.compute(frame);
+    const TileHasher::Diff diff = TileHasher::diff(m_prev, grid);
+    res.dirtyTiles = diff.changed;
+    m_frames++;
+
+    if (!m_prev.isEmpty() && !diff.any()) {
+        res.reused = true;
+        res.ocr = makeResult();
+        m_reused++;
+        return res;
+    }
+
+    QVector<QRect> regions;
+    qint64 area = 0;
+    const qint64 frameArea = qint64(frame.width()) * frame.height();
+    if (!m_prev.isEmpty() && diff.ratio() < 1.0) {
+        regions = dirtyRegions(m_hasher, grid, diff, m_marginPx);
+        for (const QRect &r : regions) area += qint64(r.width()) * r.height();
+    }
+    res.full = regions.isEmpty() || frameArea <= 0 || area > m_fullRatio * frameArea;
+
+    bool cancelled = false;
+    if (res.full) {
+        m_hits = m_detector.findKeywords(frame, m_lang, QRect(), nullptr, cancel, &cancelled);
+        area = frameArea;
+        m_full++;
+    } else {
+        QVector<OcrHit> fresh = m_detector.findKeywordsInRegions(frame, m_lang, regions, cancel, &cancelled);
+        if (!cancelled) {
+            // 区域内的旧命中作废，区域外的保留
+            QVector<OcrHit> kept;
+            for (const OcrHit &h : m_hits) {
+                bool stale = false;
+                for (const QRect &r : regions) {
+                    if (r.intersects(h.rect)) { stale = true; break; }
+                }
+                if (!stale) kept.append(h);
+            }
+            m_hits = kept + fresh;
+        }
+        res.regions = regions;
+        m_partial++;
+    }
+
+    if (cancelled) {
+        // 缓存已不可信，下一帧整图识别
+        reset();
+        res.ocr.lang = m_lang;
+        res.ocr.cancelled = true;
+        return res;
+    }
+    m_prev = grid;
+    m_areaPermille += frameArea > 0 ? qint64(1000.0 * area / frameArea) : 1000;
+    res.ocr = makeResult();
+    return res;
+}
+
+OcrResult IncrementalOcr::makeResult() const
+{
+    OcrResult r;
+    r.lang = m_lang;
+    r.hits = m_hits;
+    if (const OcrHit *hit = Detector::bestHit(m_hits, m_detector.primaryKeyword())) r.rect = hit->rect;
+    r.text = Detector::describeHits(m_hits);
+    return r;
+}
+
+IncrementalOcr::Stats IncrementalOcr::stats() const
+{
+    Stats s;
+    s.frames = m_frames;
+    s.reused = m_reused;
+    s.partial = m_partial;
+    s.full = m_full;
+    s.recognizedArea = m_areaPermille / 1000.0;
+    return s;
+}
+
+QString IncrementalOcr::statsSummary() const
+{
+    const Stats s = stats();
+    return QString("增量OCR: 帧=%1 复用=%2 局部=%3 整图=%4 平均识别面积=%5%")
+        .arg(s.frames).arg(s.reused).arg(s.partial).arg(s.full)
+        .arg(s.frames > 0 ? 100.0 * s.recognizedArea / s.frames : 0.0, 0, 'f', 1);
+}
+
+IncrementalTemplate::IncrementalTemplate(Detector &detector, const TileHasher &hasher)
+    : m_detector(detector), m_hasher(hasher)
+{
+}
+
+void IncrementalTemplate::reset()
+{
+    m_prev = TileHasher::Grid();
+    m_valid = false;
+}
+
+TemplateResult IncrementalTemplate::process(const Frame &frame, TemplateMatcher::Mode mode, bool *reusedOut)
+{
+    const TileHasher::Grid grid = m_hasher.compute(frame);
+    const TileHasher::Diff diff = TileHasher::diff(m_prev, grid);
+    bool reuse = false;
+    if (m_valid && !m_prev.isEmpty() && diff.ratio() < 1.0) {
+        if (m_last.pt.x() < 0) {
+            // 上次未命中：画面不变则仍未命中
+            reuse = !diff.any();
+        } else {
+            // 命中位置所在格子都未变化
+            const QRect hit(m_last.pt, m_last.size);
+            reuse = true;
+            for (int i = 0; i < diff.dirty.size() && reuse; ++i) {
+                if (diff.dirty[i] && m_hasher.tileRect(grid, i).intersects(hit)) reuse = false;
+            }
+        }
+    }
+    if (reusedOut) *reusedOut = reuse;
+    m_prev = grid;
+    if (reuse) {
+        m_reusedCount++;
+        return m_last;
+    }
+    TemplateResult r{QPoint(-1, -1), 0.0, QSize()};
+    if (m_tracker) r = m_tracker->process(frame, mode);
+    else r.pt = m_detector.runTemplateMatch(frame, r.score, mode, &r.size, &r.scale);
+    m_last = r;
+    m_valid = true;
+    m_runs++;
+    return r;
+}
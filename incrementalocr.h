@@ -0,0 +1,96 @@
+#ifndef INCREMENTALOCR_H
+#define INCREMENTALOCR_H
+
+#include <QRect>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+#include "detector.h"
+#include "templatetracker.h"
+#include "tilehash.h"
+
+// 按格子变化增量识别，用于连续帧
+// 与上一次识别的帧逐格比较哈希：无变化直接返回缓存结果；
+// 少量格子变化时只在变化区域（外扩一圈）重新 OCR，区域外的缓存命中保留、区域内的以新结果替换；
+// 变化面积超过 fullRatio 或分辨率变化时整图识别。每个实例只应在一个线程中使用。
+class IncrementalOcr
+{
+public:
+    struct Result {
+        OcrResult ocr;
+        bool full = false;          // 整图识别
+        bool reused = false;        // 画面无变化，直接返回缓存
+        int dirtyTiles = 0;
+        QVector<QRect> regions;     // 本次重新识别的区域
+    };
+
+    struct Stats {
+        qint64 frames = 0;
+        qint64 reused = 0;
+        qint64 partial = 0;
+        qint64 full = 0;
+        double recognizedArea = 0;  // 累计重新识别的面积占比（每帧 0~1）
+    };
+
+    IncrementalOcr(Detector &detector, const QString &langCode, const TileHasher &hasher = TileHasher());
+
+    void setFullRatio(double ratio) { m_fullRatio = ratio; }
+    // 变化区域每边外扩的像素，避免关键词被格子边界截断
+    void setMarginPx(int px) { m_marginPx = qMax(0, px); }
+    void reset();
+
+    Result process(const Frame &frame, const Detector::CancelFn &cancel = Detector::CancelFn());
+
+    Stats stats() const;
+    QString statsSummary() const;
+
+    // 把变化的格子按连通块合并为外扩后的矩形（原始帧坐标），相交的矩形再合并
+    static QVector<QRect> dirtyRegions(const TileHasher &hasher, const TileHasher::Grid &grid,
+                                       const TileHasher::Diff &diff, int marginPx);
+
+private:
+    OcrResult makeResult() const;
+
+    Detector &m_detector;
+    QString m_lang;
+    TileHasher m_hasher;
+    double m_fullRatio = 0.5;
+    int m_marginPx = 48;
+
+    TileHasher::Grid m_prev;
+    QVector<OcrHit> m_hits;
+
+    std::atomic<qint64> m_frames{0};
+    std::atomic<qint64> m_reused{0};
+    std::atomic<qint64> m_partial{0};
+    std::atomic<qint64> m_full{0};
+    std::atomic<qint64> m_areaPermille{0};
+};
+
+// 模板匹配结果缓存：上次命中位置所在的格子无变化时直接复用，
+// 上次未命中则只在画面有变化时重新匹配。
+class IncrementalTemplate
+{
+public:
+    explicit IncrementalTemplate(Detector &detector, const TileHasher &hasher = TileHasher());
+
+    // 设置后重新匹配经跟踪器进行；跟踪器需比本对象存活更久
+    void setTracker(TemplateTracker *tracker) { m_tracker = tracker; }
+    TemplateResult process(const Frame &frame, TemplateMatcher::Mode mode, bool *reusedOut = nullptr);
+    void reset();
+    qint64 runs() const { return m_runs; }
+    qint64 reused() const { return m_reusedCount; }
+
+private:
+    Detector &m_detector;
+    TemplateTracker *m_tracker = nullptr;
+    TileHasher m_hasher;
+    TileHasher::Grid m_prev;
+    TemplateResult m_last{QPoint(-1, -1), 0.0, QSize()};
+    bool m_valid = false;
+    std::atomic<qint64> m_runs{0};
+    std::atomic<qint64> m_reusedCount{0};
+};
+
+#endif // INCREMENTALOCR_H
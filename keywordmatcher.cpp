@@ -0,0 +1,61 @@
+#include "keywordmatcher.h"
+
+#include <QQueue>
+
+void KeywordMatcher::build(const QStringList &keywords)
+{
+    m_keywords.clear();
+    m_nodes = QVector<Node>(1);
+    m_maxLength = 0;
+
+    // 前缀树
+    for (const QString &kw : keywords) {
+        if (kw.isEmpty() || m_keywords.contains(kw)) continue;
+        const int index = m_keywords.size();
+        m_keywords << kw;
+        m_maxLength = qMax(m_maxLength, (int)kw.size());
+        int state = 0;
+        for (QChar c : kw) {
+            auto it = m_nodes[state].next.constFind(c);
+            if (it == m_nodes[state].next.constEnd()) {
+                m_nodes.append(Node());
+                const int created = m_nodes.size() - 1;
+                m_nodes[state].next.insert(c, created);
+                state = created;
+            } else {
+                state = it.value();
+            }
+        }
+        m_nodes[state].outputs << index;
+    }
+
+    // 按层广度优先计算失败链接，并把失败目标的输出并入当前节点
+    QQueue<int> queue;
+    for (int child : m_nodes[0].next) {
+        m_nodes[child].fail = 0;
+        queue.enqueue(child);
+    }
+    while (!queue.isEmpty()) {
+        const int state = queue.dequeue();
+        for (auto it = m_nodes[state].next.constBegin(); it != m_nodes[state].next.constEnd(); ++it) {
+            const QChar c = it.key();
+            const int child = it.value();
+            int f = m_nodes[state].fail;
+            while (f != 0 && !m_nodes[f].next.contains(c)) f = m_nodes[f].fail;
+            const int target = m_nodes[f].next.value(c, 0);
+            m_nodes[child].fail = target == child ? 0 : target;
+            m_nodes[child].outputs += m_nodes[m_nodes[child].fail].outputs;
+            queue.enqueue(child);
+        }
+    }
+}
+
+int KeywordMatcher::step(int state, QChar c) const
+{
+    while (true) {
+        auto it = m_nodes[state].next.constFind(c);
+        if (it != m_nodes[state].next.constEnd()) return it.value();
+        if (state == 0) return 0;
+        state = m_nodes[state].fail;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef KEYWORDMATCHER_H
+#define KEYWORDMATCHER_H
+
+#include <QChar>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// 多关键词流式匹配（Aho-Corasick）
+// 构建后只读，可在多个线程中同时使用；调用方自己保存当前状态，逐字符 step()，
+// 每一步通过 hitsAt() 取得在该位置结束的全部关键词（已合并后缀链上的输出）。
+class KeywordMatcher
+{
+public:
+    KeywordMatcher() = default;
+    explicit KeywordMatcher(const QStringList &keywords) { build(keywords); }
+
+    // 空串与重复关键词会被忽略
+    void build(const QStringList &keywords);
+
+    bool isEmpty() const { return m_keywords.isEmpty(); }
+    const QStringList &keywords() const { return m_keywords; }
+    int maxLength() const { return m_maxLength; }
+
+    static int rootState() { return 0; }
+    int step(int state, QChar c) const;
+    // 在 state 处结束的关键词下标
+    const QVector<int> &hitsAt(int state) const { return m_nodes[state].outputs; }
+
+private:
+    struct Node {
+        QHash<QChar, int> next;
+        int fail = 0;
+        QVector<int> outputs;
+    };
+
+    QStringList m_keywords;
+    QVector<Node> m_nodes{Node()};
+    int m_maxLength = 0;
+};
+
+#endif // KEYWORDMATCHER_H
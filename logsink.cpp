@@ -0,0 +1,139 @@
+#include "logsink.h"
+
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThread>
+#include <cstdio>
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#endif
+
+std::atomic<int> LogSink::s_level{int(LogLevel::Info)};
+
+LogSink::LogSink(int flushIntervalMs)
+    : m_flushIntervalMs(qMax(1, flushIntervalMs))
+{
+}
+
+LogSink::~LogSink()
+{
+    stop();
+    drain();
+}
+
+LogLevel LogSink::parseLevel(const QString &name, LogLevel fallback)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "debug") return LogLevel::Debug;
+    if (n == "info") return LogLevel::Info;
+    if (n == "warning" || n == "warn") return LogLevel::Warning;
+    if (n == "error") return LogLevel::Error;
+    return fallback;
+}
+
+void LogSink::start()
+{
+    if (m_thread) return;
+    m_stopRequested = false;
+    m_thread = QThread::create([this]() { writerLoop(); });
+    m_thread->setObjectName("log-writer");
+    m_thread->start();
+}
+
+void LogSink::stop()
+{
+    if (!m_thread) return;
+    m_stopRequested = true;
+    m_wake.release();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+}
+
+void LogSink::write(LogLevel level, const QString &msg)
+{
+    if (!enabled(level)) return;
+    Node *n = new Node{nullptr, QDateTime::currentMSecsSinceEpoch(), level, msg};
+    Node *head = m_head.load(std::memory_order_relaxed);
+    do {
+        n->next = head;
+    } while (!m_head.compare_exchange_weak(head, n, std::memory_order_release, std::memory_order_relaxed));
+    // 只有空栈变非空时唤醒，其余消息等待同一批写出
+    if (!head) m_wake.release();
+}
+
+void LogSink::writerLoop()
+{
+    while (true) {
+        m_wake.tryAcquire(1, m_flushIntervalMs);
+        const bool stopping = m_stopRequested.load();
+        drain();
+        if (stopping) break;
+    }
+}
+
+void LogSink::drain()
+{
+    Node *list = m_head.exchange(nullptr, std::memory_order_acquire);
+    if (!list) return;
+    // 栈是后进先出，反转回写入顺序
+    Node *ordered = nullptr;
+    while (list) {
+        Node *next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+
+    static const char *tags[] = { "[D] ", "", "[W] ", "[E] " };
+    QStringList lines;
+    QString batch;
+    for (Node *n = ordered; n; ) {
+        QString line = QDateTime::fromMSecsSinceEpoch(n->msecs).toString("yyyy-MM-dd HH:mm:ss.zzz ")
+                       + QLatin1String(tags[int(n->level)]) + n->msg;
+        batch += line;
+        batch += '\n';
+        lines << std::move(line);
+        Node *next = n->next;
+        delete n;
+        n = next;
+    }
+
+    // 向 Qt Creator Application Output 以 UTF-8 编码输出，整批只 flush 一次
+    // 需与 IDE 中 Environment->Interface->Text codec for tools = UTF-8 保持一致
+    {
+        QTextStream ts(stdout);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        ts.setEncoding(QStringConverter::Utf8);
+#else
+        ts.setCodec("UTF-8");
+#endif
+        ts << batch;
+        ts.flush();
+    }
+#ifdef _WIN32
+    // 同时写入调试器，便于在 DebugView 等工具查看
+    OutputDebugStringW(reinterpret_cast<const wchar_t *>(batch.utf16()));
+#endif
+
+    QMutexLocker lock(&m_uiMutex);
+    m_uiLines << lines;
+    const int overflow = m_uiLines.size() - m_uiBacklog;
+    if (overflow > 0) {
+        m_uiLines.erase(m_uiLines.begin(), m_uiLines.begin() + overflow);
+        m_uiDropped += overflow;
+    }
+}
+
+QStringList LogSink::takeUiLines(int *droppedOut)
+{
+    QMutexLocker lock(&m_uiMutex);
+    QStringList out;
+    out.swap(m_uiLines);
+    if (droppedOut) *droppedOut = m_uiDropped;
+    m_uiDropped = 0;
+    return out;
+}
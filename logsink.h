@@ -0,0 +1,69 @@
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+
+class QThread;
+
+enum class LogLevel { Debug = 0, Info, Warning, Error };
+
+// 各模块的日志回调：级别 + 已格式化的消息
+using LogFn = std::function<void(LogLevel, const QString &)>;
+
+// 异步批量日志
+// 任意线程 write() 只做一次无锁压栈（Treiber 栈），时间戳在写入时取毫秒数、格式化留给后台线程；
+// 后台线程被唤醒或每隔 flushIntervalMs 取走整条链表，按顺序批量写 stdout / 调试器，
+// 并放入界面缓冲，由界面定时器按固定频率 takeUiLines() 一次性追加。
+class LogSink
+{
+public:
+    explicit LogSink(int flushIntervalMs = 50);
+    ~LogSink();
+
+    // 全局级别：低于该级别的消息应在格式化之前就被跳过
+    static void setLevel(LogLevel level) { s_level.store(int(level), std::memory_order_relaxed); }
+    static LogLevel level() { return LogLevel(s_level.load(std::memory_order_relaxed)); }
+    static bool enabled(LogLevel level) { return int(level) >= s_level.load(std::memory_order_relaxed); }
+    static LogLevel parseLevel(const QString &name, LogLevel fallback = LogLevel::Info);
+
+    void start();
+    // 写出所有剩余消息后停止后台线程
+    void stop();
+
+    void write(LogLevel level, const QString &msg);
+
+    // 界面缓冲最多保留的行数，超出时丢弃最旧的行并记数
+    void setUiBacklog(int lines) { m_uiBacklog = lines; }
+    QStringList takeUiLines(int *droppedOut = nullptr);
+
+private:
+    struct Node {
+        Node *next;
+        qint64 msecs;
+        LogLevel level;
+        QString msg;
+    };
+
+    void writerLoop();
+    void drain();
+
+    static std::atomic<int> s_level;
+
+    int m_flushIntervalMs;
+    std::atomic<Node *> m_head{nullptr};
+    QSemaphore m_wake;
+    std::atomic<bool> m_stopRequested{false};
+    QThread *m_thread = nullptr;
+
+    QMutex m_uiMutex;
+    QStringList m_uiLines;
+    int m_uiBacklog = 2000;
+    int m_uiDropped = 0;
+};
+
+#endif // LOGSINK_H
@@ -10,6 +10,21 @@
 #include <QtConcurrent>
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QTimer>
+#include <memory>
+
+#include "appconfig.h"
+#include "capturesource.h"
+#include "detectpipeline.h"
+#include "incrementalocr.h"
+#include "detectrequest.h"
+#include "detectscheduler.h"
+#include "resultcache.h"
+#include "templatetracker.h"
+#include "detector.h"
+#include "logsink.h"
+#include "markrender.h"
+#include "ocrcascade.h"
 
 #ifdef _WIN32
 #  define WIN32_LEAN_AND_MEAN
@@ -47,47 +62,75 @@ private:
     static MainWindow* s_instance;
 #endif
     bool selectingWindow = false;
+    AppConfig config;
 
-    // 日志
-    void appendLog(const QString &msg);
+    // 日志：写入异步队列，界面由定时器按固定频率批量追加
+    LogSink logSink;
+    QTimer logTimer;
+    void appendLog(const QString &msg, LogLevel level = LogLevel::Info);
+    void flushLogToUi();
 
     // 交互
     void onSelectWindowClicked();
     void onRunHshjClicked();
+    void onContinuousToggled(bool on);
 
-    // 截图与识别
+    // 分阶段耗时面板，显示时每秒刷新
+    QTimer metricsTimer;
+    void onMetricsToggled(bool on);
+    void refreshMetrics();
+    void exportMetrics();
+
+    // 截图与识别：截图后端按窗口复用缓冲，选中窗口变化时重建
 #ifdef _WIN32
-    QImage captureWindow(HWND hwnd);
     static LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam);
 #endif
-    static cv::Mat qimageToMat(const QImage &img);
-    QImage loadTemplateImage();
-    QPoint runTemplateMatch(const QImage &screenshot, double &scoreOut);
-    QRect runOcrFind(const QImage &screenshot, QString *recognizedOut = nullptr);
-    QRect runOcrFindWithLang(const QImage &screenshot, const QString &langCode, QString *recognizedOut = nullptr);
+    std::unique_ptr<CaptureSource> windowCapture;
+    // 当前截图目标，0 表示未选中（Windows）或整个屏幕（X11）
+    quintptr captureTarget() const;
+    bool hasCaptureTarget() const;
+    std::unique_ptr<CaptureSource> createCapture();
+    QImage captureSelected();
+    // 模板匹配与 OCR 核心（dldl-core 库）
+    Detector detector;
 
     // 渲染截图与标记
     void showScreenshotWithMarks(const QImage &shot, const QPoint &tmplPt, const QRect &ocrRectFast, const QRect &ocrRectAcc);
+    // 当前截图缩放后的预览底图，标记在其上重画
+    MarkRender::PreviewCache previewCache{300};
+
+    // 异步OCR：fast / accuracy 按配置的级联模式调度，fast 结果先行展示
+    OcrCascade ocrCascade{detector};
+    OcrCascade::Mode ocrMode = OcrCascade::Mode::Cascade;
+    void onOcrFinished(quint64 generation, const OcrCascade::Outcome &o);
+    void showOcrResults(const OcrResult &fast, const OcrResult &acc, const QString &accState);
 
-    // 异步OCR
-    struct OcrResult { QRect rect; QString text; QString lang; };
-    QFuture<OcrResult> futureFast;
-    QFuture<OcrResult> futureAcc;
-    QFutureWatcher<OcrResult> watcherFast;
-    QFutureWatcher<OcrResult> watcherAcc;
-    void onOcrFinished();
+    // 单次识别（模板 + OCR）按代号调度：连续点击时只识别最新截图，过期结果直接丢弃
+    DetectScheduler scheduler;
+    // 见过的画面直接复用结果（resultCacheEnabled 关闭时不使用）
+    ResultCache resultCache;
 
     // 缓存最近一次截图，便于异步回调时重绘标注
     QImage lastScreenshot;
 
     // 异步模板匹配
-    struct TemplateResult { QPoint pt; double score; };
-    QFuture<TemplateResult> futureTmpl;
-    QFutureWatcher<TemplateResult> watcherTmpl;
-    void onTemplateFinished();
+    void onTemplateFinished(quint64 generation, const TemplateResult &r);
+    void applyTemplateResult(const TemplateResult &r);
     QPoint lastTemplatePt = QPoint(-1, -1);
     double lastTemplateScore = 0.0;
     QRect lastRectFast;
     QRect lastRectAcc;
+    // 最近一次 OCR 命中的位置（全图坐标），作为下一次 ROI 识别的依据
+    QRect lastOcrRect;
+
+    // 连续识别管线（模板 + fast OCR），画面无变化时跳过
+    std::unique_ptr<DetectPipeline> pipeline;
+    // 按格子变化增量识别，由管线阶段线程使用（pipelineIncremental 关闭时为空）
+    std::shared_ptr<IncrementalOcr> pipelineOcr;
+    std::shared_ptr<IncrementalTemplate> pipelineTemplate;
+    // 连续帧的模板跟踪（templateTracking 关闭时为空）
+    std::shared_ptr<TemplateTracker> pipelineTracker;
+    TemplateTracker::Params trackerParams() const;
+    void applyPipelineOcr(const OcrResult &r);
 };
 #endif // MAINWINDOW_H
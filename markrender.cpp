@@ -0,0 +1,78 @@
+#include "markrender.h"
+
+#include <QPainter>
+#include <QPen>
+
+namespace MarkRender {
+
+QImage render(const QImage &shot, const QPoint &tmplPt, const QRect &ocrRectFast, const QRect &ocrRectAcc,
+              int maxWidth)
+{
+    double scale = 1.0;
+    return drawMarks(scaledBase(shot, maxWidth, &scale), scale, tmplPt, ocrRectFast, ocrRectAcc);
+}
+
+QImage scaledBase(const QImage &shot, int maxWidth, double *scaleOut)
+{
+    *scaleOut = 1.0;
+    if (shot.isNull()) return QImage();
+    // 先缩小再转换格式，只处理预览大小的像素
+    if (shot.width() > maxWidth) {
+        const int targetH = (int)((double)maxWidth / shot.width() * shot.height());
+        *scaleOut = (double)maxWidth / shot.width();
+        return shot.scaled(maxWidth, targetH, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                   .convertToFormat(QImage::Format_RGBA8888);
+    }
+    return shot.convertToFormat(QImage::Format_RGBA8888);
+}
+
+QImage drawMarks(const QImage &base, double scale, const QPoint &tmplPt, const QRect &ocrRectFast,
+                 const QRect &ocrRectAcc)
+{
+    QImage canvas = base.copy();
+    if (canvas.isNull()) return canvas;
+    QPainter p(&canvas);
+    p.setRenderHint(QPainter::Antialiasing);
+    // 标记按截图尺寸设计，换算到预览坐标；线宽与半径保留下限，缩小后仍可见
+    const double pen = qMax(1.0, 3.0 * scale);
+    auto mapRect = [scale](const QRect &r) {
+        return QRectF(r.x() * scale, r.y() * scale, r.width() * scale, r.height() * scale);
+    };
+
+    // 绘制模板匹配点
+    if (tmplPt.x() >= 0 && tmplPt.y() >= 0) {
+        const double radius = qMax(3.0, 10.0 * scale);
+        p.setPen(QPen(Qt::green, pen));
+        p.drawEllipse(QPointF(tmplPt.x() * scale, tmplPt.y() * scale), radius, radius);
+    }
+
+    // 绘制OCR矩形（fast 红色, accuracy 蓝色）
+    if (ocrRectFast.isValid()) {
+        p.setPen(QPen(Qt::red, pen));
+        p.drawRect(mapRect(ocrRectFast));
+    }
+    if (ocrRectAcc.isValid()) {
+        p.setPen(QPen(Qt::blue, pen));
+        p.drawRect(mapRect(ocrRectAcc));
+    }
+    p.end();
+    return canvas;
+}
+
+QImage PreviewCache::render(const QImage &shot, const QPoint &tmplPt, const QRect &ocrRectFast, const QRect &ocrRectAcc)
+{
+    m_lastHit = !m_base.isNull() && shot.cacheKey() == m_key;
+    if (!m_lastHit) {
+        m_base = scaledBase(shot, m_maxWidth, &m_scale);
+        m_key = shot.cacheKey();
+    }
+    return drawMarks(m_base, m_scale, tmplPt, ocrRectFast, ocrRectAcc);
+}
+
+void PreviewCache::clear()
+{
+    m_base = QImage();
+    m_key = 0;
+}
+
+} // namespace MarkRender
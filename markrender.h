@@ -0,0 +1,43 @@
+#ifndef MARKRENDER_H
+#define MARKRENDER_H
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+
+// 截图预览：在截图上绘制识别标记并缩放到展示宽度，不依赖界面控件
+namespace MarkRender {
+
+// 模板点画绿圈，fast / accuracy 的 OCR 框分别画红 / 蓝框；宽度超过 maxWidth 时等比例缩小
+QImage render(const QImage &shot, const QPoint &tmplPt, const QRect &ocrRectFast, const QRect &ocrRectAcc,
+              int maxWidth = 300);
+
+// 缩放到展示宽度的底图，scaleOut 为预览与截图的尺寸比
+QImage scaledBase(const QImage &shot, int maxWidth, double *scaleOut);
+// 在底图副本上按 scale 把截图坐标换算后绘制标记
+QImage drawMarks(const QImage &base, double scale, const QPoint &tmplPt, const QRect &ocrRectFast,
+                 const QRect &ocrRectAcc);
+
+// 按帧缓存缩放后的底图：同一截图多次重绘标记（模板、fast、accuracy 结果先后到达）时
+// 只缩放一次，之后每次只在小图上画标记。仅在界面线程使用。
+class PreviewCache
+{
+public:
+    explicit PreviewCache(int maxWidth = 300) : m_maxWidth(maxWidth) {}
+
+    QImage render(const QImage &shot, const QPoint &tmplPt, const QRect &ocrRectFast, const QRect &ocrRectAcc);
+    // 上一次 render 是否复用了缓存的底图
+    bool lastHit() const { return m_lastHit; }
+    void clear();
+
+private:
+    int m_maxWidth;
+    qint64 m_key = 0;       // QImage::cacheKey，像素被修改后会变化
+    QImage m_base;
+    double m_scale = 1.0;
+    bool m_lastHit = false;
+};
+
+} // namespace MarkRender
+
+#endif // MARKRENDER_H
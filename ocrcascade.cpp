@@ -0,0 +1,116 @@
+#include "ocrcascade.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QtConcurrent>
+
+OcrCascade::OcrCascade(Detector &detector)
+    : m_detector(detector)
+{
+}
+
+bool OcrCascade::accepted(const OcrResult &r) const
+{
+    if (r.cancelled || !r.rect.isValid()) return false;
+    const OcrHit *hit = Detector::bestHit(r.hits, m_detector.primaryKeyword());
+    return hit && hit->confidence >= m_minConfidence;
+}
+
+OcrCascade::Outcome OcrCascade::run(const Frame &screenshot, const QRect &roi, Mode mode,
+                                    const std::atomic<bool> *cancel,
+                                    const std::function<void(const OcrResult &)> &onFast)
+{
+    QElapsedTimer total; total.start();
+    Outcome o;
+    std::atomic<bool> stopAccuracy{false};
+    const Detector::CancelFn cancelFast = [cancel]() { return cancel && cancel->load(std::memory_order_relaxed); };
+    const Detector::CancelFn cancelAccuracy = [cancel, &stopAccuracy]() {
+        return stopAccuracy.load(std::memory_order_relaxed) || (cancel && cancel->load(std::memory_order_relaxed));
+    };
+
+    auto runFast = [&]() {
+        QElapsedTimer t; t.start();
+        o.fast = m_detector.runOcr(screenshot, m_fastLang, roi, false, cancelFast);
+        o.fastMs = t.nsecsElapsed() / 1e6;
+        o.fastAccepted = accepted(o.fast);
+        if (onFast) onFast(o.fast);
+    };
+    auto runAccuracy = [&]() {
+        QElapsedTimer t; t.start();
+        o.accuracy = m_detector.runOcr(screenshot, m_accLang, roi, false, cancelAccuracy);
+        o.accuracyMs = t.nsecsElapsed() / 1e6;
+        o.accuracyRan = true;
+        o.accuracyCancelled = o.accuracy.cancelled;
+    };
+
+    if (mode == Mode::Cascade) {
+        runFast();
+        if (!o.fastAccepted && !cancelFast()) runAccuracy();
+    } else {
+        // 两个模型并发：accuracy 放到全局线程池，fast 在当前线程
+        QFuture<void> acc = QtConcurrent::run(runAccuracy);
+        runFast();
+        if (mode == Mode::Speculative && o.fastAccepted) stopAccuracy = true;
+        acc.waitForFinished();
+    }
+
+    if (o.fastAccepted) o.final = o.fast;
+    else if (o.accuracyRan && o.accuracy.rect.isValid()) o.final = o.accuracy;
+    else o.final = o.fast;
+    o.totalMs = total.nsecsElapsed() / 1e6;
+    record(mode, o);
+    return o;
+}
+
+void OcrCascade::record(Mode mode, const Outcome &o)
+{
+    QMutexLocker lock(&m_mutex);
+    ModeStats &s = m_stats[int(mode)];
+    s.runs++;
+    if (o.final.rect.isValid()) s.hits++;
+    if (o.fastAccepted) s.fastAccepted++;
+    if (o.accuracyRan) s.accuracyRuns++;
+    if (o.accuracyCancelled) s.accuracyCancelled++;
+    s.totalMs += o.totalMs;
+    s.maxMs = qMax(s.maxMs, o.totalMs);
+}
+
+OcrCascade::ModeStats OcrCascade::stats(Mode mode) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats[int(mode)];
+}
+
+QString OcrCascade::statsSummary() const
+{
+    QStringList parts;
+    for (int i = 0; i < int(Mode::Count); ++i) {
+        const ModeStats s = stats(Mode(i));
+        if (!s.runs) continue;
+        parts << QString("%1: %2次 命中率=%3% fast采纳=%4 accuracy启动=%5(取消%6) 平均=%7ms 最大=%8ms")
+                     .arg(modeName(Mode(i))).arg(s.runs).arg(100.0 * s.hits / s.runs, 0, 'f', 0)
+                     .arg(s.fastAccepted).arg(s.accuracyRuns).arg(s.accuracyCancelled)
+                     .arg(s.totalMs / s.runs, 0, 'f', 1).arg(s.maxMs, 0, 'f', 1);
+    }
+    return parts.isEmpty() ? QString("暂无") : parts.join(" | ");
+}
+
+QString OcrCascade::modeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::Parallel: return QStringLiteral("parallel");
+    case Mode::Cascade: return QStringLiteral("cascade");
+    case Mode::Speculative: return QStringLiteral("speculative");
+    default: return QString();
+    }
+}
+
+OcrCascade::Mode OcrCascade::parseMode(const QString &name, Mode fallback)
+{
+    const QString n = name.trimmed().toLower();
+    for (int i = 0; i < int(Mode::Count); ++i) {
+        if (n == modeName(Mode(i))) return Mode(i);
+    }
+    return fallback;
+}
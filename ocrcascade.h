@@ -0,0 +1,75 @@
+#ifndef OCRCASCADE_H
+#define OCRCASCADE_H
+
+#include <QMutex>
+#include <QRect>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+#include "detector.h"
+
+// fast / accuracy 两个模型的调度
+// Parallel：两个模型同时识别（旧行为）
+// Cascade：先跑 fast，未命中或置信度低于阈值时才在同一 ROI 上跑 accuracy
+// Speculative：两个同时启动，fast 结果被采纳后立即取消仍在识别的 accuracy
+class OcrCascade
+{
+public:
+    enum class Mode { Parallel, Cascade, Speculative, Count };
+
+    struct Outcome {
+        OcrResult fast;
+        OcrResult accuracy;
+        OcrResult final;            // 采纳的结果
+        bool fastAccepted = false;
+        bool accuracyRan = false;
+        bool accuracyCancelled = false;
+        double fastMs = 0.0;
+        double accuracyMs = 0.0;
+        double totalMs = 0.0;
+    };
+
+    struct ModeStats {
+        qint64 runs = 0;
+        qint64 hits = 0;
+        qint64 fastAccepted = 0;
+        qint64 accuracyRuns = 0;
+        qint64 accuracyCancelled = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    explicit OcrCascade(Detector &detector);
+
+    void setLangs(const QString &fastLang, const QString &accuracyLang) { m_fastLang = fastLang; m_accLang = accuracyLang; }
+    // 主关键词置信度达到该值（0~100）即采纳 fast 结果
+    void setMinConfidence(float conf) { m_minConfidence = conf; }
+
+    // 在调用线程中同步执行；cancel 置位时两个模型都尽快停止。
+    // onFast 在 fast 结果出来时调用（调用线程），可用于先行展示。
+    Outcome run(const Frame &screenshot, const QRect &roi, Mode mode,
+                const std::atomic<bool> *cancel = nullptr,
+                const std::function<void(const OcrResult &)> &onFast = {});
+
+    bool accepted(const OcrResult &r) const;
+
+    ModeStats stats(Mode mode) const;
+    QString statsSummary() const;
+
+    static QString modeName(Mode mode);
+    static Mode parseMode(const QString &name, Mode fallback = Mode::Cascade);
+
+private:
+    void record(Mode mode, const Outcome &o);
+
+    Detector &m_detector;
+    QString m_fastLang = QStringLiteral("chi_sim_fast");
+    QString m_accLang = QStringLiteral("chi_sim_accuracy");
+    float m_minConfidence = 60.0f;
+
+    mutable QMutex m_mutex;
+    ModeStats m_stats[int(Mode::Count)];
+};
+
+#endif // OCRCASCADE_H
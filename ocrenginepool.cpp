@@ -0,0 +1,210 @@
+#include "ocrenginepool.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <tesseract/baseapi.h>
+
+#include "stagemetrics.h"
+
+OcrEnginePool::Lease::Lease(Lease &&other) noexcept
+    : m_pool(other.m_pool), m_langCode(std::move(other.m_langCode)), m_api(other.m_api)
+{
+    other.m_pool = nullptr;
+    other.m_api = nullptr;
+}
+
+OcrEnginePool::Lease &OcrEnginePool::Lease::operator=(Lease &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_langCode = std::move(other.m_langCode);
+        m_api = other.m_api;
+        other.m_pool = nullptr;
+        other.m_api = nullptr;
+    }
+    return *this;
+}
+
+OcrEnginePool::Lease::~Lease()
+{
+    release();
+}
+
+void OcrEnginePool::Lease::release()
+{
+    if (m_pool && m_api) m_pool->giveBack(m_langCode, m_api);
+    m_pool = nullptr;
+    m_api = nullptr;
+}
+
+OcrEnginePool::OcrEnginePool()
+{
+    m_maxPerLang = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+}
+
+OcrEnginePool::~OcrEnginePool()
+{
+    waitForWarmUp();
+    QMutexLocker lock(&m_mutex);
+    for (Slot &slot : m_slots) {
+        for (tesseract::TessBaseAPI *api : slot.idle) {
+            api->End();
+            delete api;
+        }
+        slot.idle.clear();
+    }
+}
+
+void OcrEnginePool::setMaxPerLang(int n)
+{
+    QMutexLocker lock(&m_mutex);
+    m_maxPerLang = qMax(1, n);
+    m_cond.wakeAll();
+}
+
+tesseract::TessBaseAPI *OcrEnginePool::createEngine(const QString &langCode)
+{
+    // 调用方已通过 Slot::creating 预留名额，此处不持锁执行耗时的 Init
+    TessModelPtr model;
+    QString langParam;
+    if (!m_resolve || !m_resolve(langCode, &model, &langParam) || !model) {
+        log(QString("[OCR池] 无法解析模型: %1").arg(langCode), LogLevel::Warning);
+        QMutexLocker lock(&m_mutex);
+        m_slots[langCode].metrics.initFailures++;
+        return nullptr;
+    }
+
+    QElapsedTimer timer; timer.start();
+    auto *api = new tesseract::TessBaseAPI();
+    const QByteArray langUtf8 = langParam.toUtf8();
+    // 从内存中的模型初始化，datapath 不参与模型查找
+    if (api->Init(model->data(), int(model->size()), langUtf8.constData(), tesseract::OEM_DEFAULT,
+                  nullptr, 0, nullptr, nullptr, false, nullptr)) {
+        delete api;
+        log(QString("[OCR池] Tesseract初始化失败(%1) 模型=%2").arg(langCode, model->path()), LogLevel::Warning);
+        QMutexLocker lock(&m_mutex);
+        m_slots[langCode].metrics.initFailures++;
+        return nullptr;
+    }
+    const double ms = timer.nsecsElapsed() / 1e6;
+    StageMetrics::record(Stage::TessInit, quint64(timer.nsecsElapsed() / 1000));
+
+    QMutexLocker lock(&m_mutex);
+    Metrics &m = m_slots[langCode].metrics;
+    m.initCount++;
+    m.lastInitMs = ms;
+    m.maxInitMs = qMax(m.maxInitMs, ms);
+    m.avgInitMs += (ms - m.avgInitMs) / m.initCount;
+    lock.unlock();
+    log(QString("[OCR池] %1 初始化完成，耗时 %2 ms").arg(langCode).arg(ms, 0, 'f', 1));
+    return api;
+}
+
+void OcrEnginePool::warmUp(const QStringList &langCodes, int perLang)
+{
+    for (const QString &lang : langCodes) {
+        for (int i = 0; i < perLang; ++i) {
+            {
+                QMutexLocker lock(&m_mutex);
+                Slot &slot = m_slots[lang];
+                slot.metrics.langCode = lang;
+                if (slot.total + slot.creating >= m_maxPerLang) break;
+                slot.creating++;
+                slot.warming++;
+            }
+            m_warmups << QtConcurrent::run([this, lang]() {
+                tesseract::TessBaseAPI *api = createEngine(lang);
+                QMutexLocker lock(&m_mutex);
+                Slot &slot = m_slots[lang];
+                slot.creating--;
+                slot.warming--;
+                if (api) {
+                    slot.total++;
+                    slot.idle.append(api);
+                }
+                m_cond.wakeAll();
+            });
+        }
+    }
+}
+
+void OcrEnginePool::waitForWarmUp()
+{
+    for (QFuture<void> &f : m_warmups) f.waitForFinished();
+    m_warmups.clear();
+}
+
+OcrEnginePool::Lease OcrEnginePool::acquire(const QString &langCode)
+{
+    QMutexLocker lock(&m_mutex);
+    {
+        Metrics &m = m_slots[langCode].metrics;
+        m.langCode = langCode;
+        m.acquireCount++;
+    }
+    bool waited = false;
+    for (;;) {
+        // 等待期间其他线程可能插入新的语言，需每轮重新取引用
+        Slot &slot = m_slots[langCode];
+        if (!slot.idle.isEmpty()) {
+            return Lease(this, langCode, slot.idle.takeLast());
+        }
+        // 预热中的实例即将可用时优先等待，避免重复加载模型
+        if (slot.warming == 0 && slot.total + slot.creating < m_maxPerLang) {
+            slot.creating++;
+            break;
+        }
+        if (!waited) { slot.metrics.waitCount++; waited = true; }
+        m_cond.wait(&m_mutex);
+    }
+    lock.unlock();
+
+    tesseract::TessBaseAPI *api = createEngine(langCode);
+
+    lock.relock();
+    Slot &slot = m_slots[langCode];
+    slot.creating--;
+    if (api) slot.total++;
+    m_cond.wakeAll();
+    if (!api) return Lease();
+    return Lease(this, langCode, api);
+}
+
+void OcrEnginePool::giveBack(const QString &langCode, tesseract::TessBaseAPI *api)
+{
+    // 仅释放图像与识别结果，保留已加载的模型
+    api->Clear();
+    QMutexLocker lock(&m_mutex);
+    m_slots[langCode].idle.append(api);
+    m_cond.wakeAll();
+}
+
+QList<OcrEnginePool::Metrics> OcrEnginePool::metrics() const
+{
+    QMutexLocker lock(&m_mutex);
+    QList<Metrics> out;
+    for (auto it = m_slots.cbegin(); it != m_slots.cend(); ++it) {
+        Metrics m = it.value().metrics;
+        m.langCode = it.key();
+        m.total = it.value().total;
+        m.idle = it.value().idle.size();
+        out << m;
+    }
+    return out;
+}
+
+QString OcrEnginePool::metricsSummary() const
+{
+    QStringList parts;
+    for (const Metrics &m : metrics()) {
+        parts << QString("%1 实例=%2 空闲=%3 init=%4次 avg=%5ms max=%6ms 等待=%7/%8")
+                     .arg(m.langCode).arg(m.total).arg(m.idle).arg(m.initCount)
+                     .arg(m.avgInitMs, 0, 'f', 1).arg(m.maxInitMs, 0, 'f', 1)
+                     .arg(m.waitCount).arg(m.acquireCount);
+    }
+    return parts.join("; ");
+}
@@ -0,0 +1,107 @@
+#ifndef OCRENGINEPOOL_H
+#define OCRENGINEPOOL_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFuture>
+#include <functional>
+
+#include "logsink.h"
+#include "tessmodelregistry.h"
+
+namespace tesseract { class TessBaseAPI; }
+
+// Tesseract 引擎池
+// 按语言变体（chi_sim_fast / chi_sim_accuracy）缓存已 Init 的 TessBaseAPI。
+// 每个工作线程同一时刻最多租用一个实例，用完 Clear() 后归还，模型只加载一次。
+class OcrEnginePool
+{
+public:
+    using LogFn = ::LogFn;
+    // 解析语言变体对应的已映射模型与传给 Init 的语言名，失败返回 false
+    using ResolveFn = std::function<bool(const QString &langCode, TessModelPtr *model, QString *langParam)>;
+
+    struct Metrics {
+        QString langCode;
+        int total = 0;          // 已初始化的实例数
+        int idle = 0;           // 空闲实例数
+        int initCount = 0;      // Init 成功次数
+        int initFailures = 0;   // Init 失败次数
+        double lastInitMs = 0.0;
+        double avgInitMs = 0.0;
+        double maxInitMs = 0.0;
+        qint64 acquireCount = 0;
+        qint64 waitCount = 0;   // 因池满而等待的次数
+    };
+
+    // 租约：析构时自动 Clear() 并归还
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease();
+
+        tesseract::TessBaseAPI *api() const { return m_api; }
+        explicit operator bool() const { return m_api != nullptr; }
+        void release();
+
+    private:
+        friend class OcrEnginePool;
+        Lease(OcrEnginePool *pool, const QString &langCode, tesseract::TessBaseAPI *api)
+            : m_pool(pool), m_langCode(langCode), m_api(api) {}
+        OcrEnginePool *m_pool = nullptr;
+        QString m_langCode;
+        tesseract::TessBaseAPI *m_api = nullptr;
+    };
+
+    OcrEnginePool();
+    ~OcrEnginePool();
+
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+    void setResolver(ResolveFn fn) { m_resolve = std::move(fn); }
+    // 每种语言变体的实例上限，默认等于全局线程池大小
+    void setMaxPerLang(int n);
+    int maxPerLang() const { return m_maxPerLang; }
+
+    // 后台预热：为每种语言变体各初始化 perLang 个实例
+    void warmUp(const QStringList &langCodes, int perLang = 1);
+    void waitForWarmUp();
+
+    // 获取一个已初始化的实例；池满时阻塞等待，初始化失败返回空租约
+    Lease acquire(const QString &langCode);
+
+    QList<Metrics> metrics() const;
+    QString metricsSummary() const;
+
+private:
+    struct Slot {
+        QVector<tesseract::TessBaseAPI *> idle;
+        int total = 0;      // 已创建（含租出）的实例数
+        int creating = 0;   // 正在 Init 的实例数
+        int warming = 0;    // 其中由后台预热发起的实例数
+        Metrics metrics;
+    };
+
+    tesseract::TessBaseAPI *createEngine(const QString &langCode);
+    void giveBack(const QString &langCode, tesseract::TessBaseAPI *api);
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    QHash<QString, Slot> m_slots;
+    QList<QFuture<void>> m_warmups;
+    int m_maxPerLang = 1;
+    LogFn m_log;
+    ResolveFn m_resolve;
+};
+
+#endif // OCRENGINEPOOL_H
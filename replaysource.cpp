@@ -0,0 +1,150 @@
+#include "replaysource.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QThread>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+ReplaySource::ReplaySource(const QString &path, Pacing pacing, double fallbackFps)
+    : m_path(path), m_pacing(pacing), m_fps(fallbackFps > 0 ? fallbackFps : 30.0)
+{
+    const QFileInfo fi(path);
+    if (fi.isDir()) {
+        m_files = ImageSequenceCapture::listFrames(path);
+        loadTimestamps();
+        m_valid = !m_files.isEmpty();
+    } else {
+        m_video.reset(new cv::VideoCapture(path.toStdString()));
+        m_frame.reset(new cv::Mat());
+        m_valid = m_video->isOpened();
+        if (m_valid) {
+            m_videoFrames = qint64(m_video->get(cv::CAP_PROP_FRAME_COUNT));
+            const double fps = m_video->get(cv::CAP_PROP_FPS);
+            if (fps > 0) m_fps = fps;
+        }
+    }
+    m_ended = !m_valid;
+}
+
+ReplaySource::~ReplaySource()
+{
+    releaseBuffers();
+}
+
+void ReplaySource::loadTimestamps()
+{
+    // 缺省按 fps 均匀排列
+    m_timestamps.resize(m_files.size());
+    for (int i = 0; i < m_files.size(); ++i) m_timestamps[i] = qint64(i * 1000.0 / m_fps);
+
+    QFile f(QDir(m_path).filePath("timestamps.txt"));
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+    QHash<QString, qint64> byName;
+    QTextStream in(&f);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const QStringList parts = line.split(QRegularExpression("[,\\s]+"), Qt::SkipEmptyParts);
+        bool ok = false;
+        const qint64 ms = parts.value(1).toLongLong(&ok);
+        if (parts.size() >= 2 && ok) byName.insert(parts.at(0), ms);
+    }
+    for (int i = 0; i < m_files.size(); ++i) {
+        auto it = byName.constFind(m_files.at(i));
+        if (it != byName.constEnd()) m_timestamps[i] = it.value();
+    }
+}
+
+int ReplaySource::frameCount() const
+{
+    return m_video ? int(m_videoFrames) : m_files.size();
+}
+
+QString ReplaySource::name() const
+{
+    return QString("replay:%1 (%2 帧, %3)").arg(m_path).arg(frameCount())
+        .arg(m_pacing == Pacing::Realtime ? "原速" : "全速");
+}
+
+ReplaySource::Pacing ReplaySource::parsePacing(const QString &name, Pacing fallback)
+{
+    const QString n = name.trimmed().toLower();
+    if (n == "realtime" || n == "original") return Pacing::Realtime;
+    if (n == "max" || n == "fast") return Pacing::AsFastAsPossible;
+    return fallback;
+}
+
+bool ReplaySource::advance(qint64 *tsMs)
+{
+    if (m_video) {
+        // grab() 在 FFmpeg / GStreamer 后端下仍会解码该帧，只省去 retrieve() 的颜色转换与拷贝；
+        // 原速回放跳过的帧照样付出解码开销，跟不上时应降低回放速度而不是依赖跳帧
+        if (!m_video->grab()) return false;
+        *tsMs = qint64(m_video->get(cv::CAP_PROP_POS_MSEC));
+        return true;
+    }
+    if (m_index + 1 >= m_files.size()) return false;
+    ++m_index;
+    *tsMs = m_timestamps.at(m_index);
+    return true;
+}
+
+QSize ReplaySource::prepare()
+{
+    if (m_video) {
+        if (!m_video->retrieve(*m_frame) || m_frame->empty()) return QSize();
+        return QSize(m_frame->cols, m_frame->rows);
+    }
+    m_reader.setFileName(QDir(m_path).filePath(m_files.at(m_index)));
+    return m_reader.size();
+}
+
+QSize ReplaySource::nextFrameSize()
+{
+    for (;;) {
+        qint64 ts = 0;
+        if (m_ended || !advance(&ts)) {
+            m_ended = true;
+            return QSize();
+        }
+        if (m_pacing == Pacing::Realtime) {
+            if (!m_clock.isValid()) {
+                m_clock.start();
+                m_t0 = ts;
+            }
+            const qint64 due = ts - m_t0;
+            const qint64 now = m_clock.elapsed();
+            // 保持原始节奏：已经过期的帧直接跳过，不补播
+            if (now - due > m_lateToleranceMs) {
+                m_skipped++;
+                continue;
+            }
+            if (due > now) QThread::msleep(quint64(due - now));
+        }
+        m_lastTs = ts;
+        const QSize size = prepare();
+        if (!size.isEmpty()) return size;
+        log(QString("回放帧读取失败: %1 @%2ms").arg(m_path).arg(ts), LogLevel::Warning);
+    }
+}
+
+bool ReplaySource::captureInto(Buffer &buf)
+{
+    if (m_video) {
+        // 直接转换进复用缓冲，BGRA 内存布局即 ARGB32
+        cv::Mat dst(buf.image.height(), buf.image.width(), CV_8UC4, buf.image.bits(), size_t(buf.image.bytesPerLine()));
+        switch (m_frame->channels()) {
+        case 1: cv::cvtColor(*m_frame, dst, cv::COLOR_GRAY2BGRA); break;
+        case 4: m_frame->copyTo(dst); break;
+        default: cv::cvtColor(*m_frame, dst, cv::COLOR_BGR2BGRA); break;
+        }
+        return true;
+    }
+    return ImageSequenceCapture::readFrame(m_reader, &buf.image);
+}
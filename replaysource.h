@@ -0,0 +1,76 @@
+#ifndef REPLAYSOURCE_H
+#define REPLAYSOURCE_H
+
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "capturesource.h"
+
+namespace cv { class VideoCapture; class Mat; }
+
+// 录制会话回放，用于离线复现与压测
+// 来源为视频文件（OpenCV VideoCapture，时间戳取自容器）或 PNG 序列目录：
+// 目录中有 timestamps.txt（每行“文件名 毫秒”或“文件名,毫秒”）时按其时间戳，否则按 fps 均匀排列。
+// Realtime 按原始节奏出帧，消费方跟不上时跳过已过期的帧（计入 skipped）；AsFastAsPossible 不等待也不跳帧。
+class ReplaySource : public CaptureSource
+{
+public:
+    enum class Pacing { Realtime, AsFastAsPossible };
+
+    explicit ReplaySource(const QString &path, Pacing pacing = Pacing::Realtime, double fallbackFps = 30.0);
+    ~ReplaySource() override;
+
+    bool isValid() const { return m_valid; }
+    bool atEnd() const override { return m_ended; }
+    QString name() const override;
+
+    // Realtime 下落后超过该值的帧会被跳过
+    void setLateToleranceMs(int ms) { m_lateToleranceMs = ms; }
+    // 最近一帧在录制中的时间戳（毫秒）
+    qint64 lastTimestampMs() const { return m_lastTs; }
+    qint64 skipped() const { return m_skipped; }
+    int frameCount() const;
+
+    static Pacing parsePacing(const QString &name, Pacing fallback = Pacing::Realtime);
+
+protected:
+    QSize nextFrameSize() override;
+    bool captureInto(Buffer &buf) override;
+
+private:
+    // 前进到下一帧并给出其时间戳（视频帧在此已解码，只是尚未转换颜色）；没有更多帧时返回 false
+    bool advance(qint64 *tsMs);
+    // 取出当前帧（视频做颜色转换，PNG 读取头信息），返回尺寸
+    QSize prepare();
+    void loadTimestamps();
+
+    QString m_path;
+    Pacing m_pacing;
+    double m_fps;
+    bool m_valid = false;
+    bool m_ended = false;
+    int m_lateToleranceMs = 100;
+
+    // PNG 序列
+    QStringList m_files;
+    QVector<qint64> m_timestamps;
+    int m_index = -1;
+    QImageReader m_reader;
+
+    // 视频
+    std::unique_ptr<cv::VideoCapture> m_video;
+    std::unique_ptr<cv::Mat> m_frame;
+    qint64 m_videoFrames = 0;
+
+    QElapsedTimer m_clock;
+    qint64 m_t0 = 0;
+    qint64 m_lastTs = 0;
+    std::atomic<qint64> m_skipped{0};
+};
+
+#endif // REPLAYSOURCE_H
@@ -0,0 +1,170 @@
+#include "resultcache.h"
+
+#include <QMutexLocker>
+#include <bitset>
+#include <opencv2/imgproc.hpp>
+
+#include "imageconvert.h"
+
+namespace {
+// 与帧变化检测的默认缩小倍数一致，两者共用帧上同一张缩小灰度图
+constexpr int kHashDownscale = 8;
+} // namespace
+
+ResultCache::ResultCache(int capacity, int tolerance)
+    : m_capacity(qMax(1, capacity)), m_tolerance(qMax(0, tolerance))
+{
+}
+
+ResultCache::Key ResultCache::hash(const Frame &frame, const QRect &roi)
+{
+    Key key;
+    if (frame.isNull()) return key;
+    const QRect area = roi.isValid() ? roi.intersected(frame.rect()) : frame.rect();
+    if (area.isEmpty()) return key;
+    key.frameSize = frame.size();
+    key.region = area;
+
+    // 缩小为 17x16 灰度，每行比较相邻像素得到 16x16 位
+    const cv::Size hashSize(17, 16);
+    const cv::Rect small(area.x() / kHashDownscale, area.y() / kHashDownscale,
+                         area.width() / kHashDownscale, area.height() / kHashDownscale);
+    cv::Mat gray;
+    if (small.width >= hashSize.width && small.height >= hashSize.height) {
+        const cv::Mat plane = frame.graySmall(kHashDownscale);
+        cv::resize(plane(small & cv::Rect(0, 0, plane.cols, plane.rows)), gray, hashSize, 0, 0, cv::INTER_AREA);
+    } else {
+        QImage holder;
+        const cv::Mat bgra = ImageConvert::bgraView(frame.image(), &holder)(cv::Rect(area.x(), area.y(), area.width(), area.height()));
+        cv::Mat smallBgra;
+        cv::resize(bgra, smallBgra, hashSize, 0, 0, cv::INTER_AREA);
+        cv::cvtColor(smallBgra, gray, cv::COLOR_BGRA2GRAY);
+    }
+    for (int y = 0; y < 16; ++y) {
+        const uchar *line = gray.ptr<uchar>(y);
+        for (int x = 0; x < 16; ++x) {
+            if (line[x] < line[x + 1]) {
+                const int bit = y * 16 + x;
+                key.bits[bit / 64] |= quint64(1) << (bit % 64);
+            }
+        }
+    }
+    return key;
+}
+
+int ResultCache::distance(const Key &a, const Key &b)
+{
+    int d = 0;
+    for (size_t i = 0; i < a.bits.size(); ++i) d += int(std::bitset<64>(a.bits[i] ^ b.bits[i]).count());
+    return d;
+}
+
+void ResultCache::setCapacity(int capacity)
+{
+    QMutexLocker lock(&m_mutex);
+    m_capacity = qMax(1, capacity);
+    while (int(m_entries.size()) > m_capacity) {
+        m_entries.pop_back();
+        m_evictions++;
+    }
+}
+
+void ResultCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_entries.clear();
+}
+
+ResultCache::Entry *ResultCache::find(const Key &key, Kind kind, const QString &variant)
+{
+    // 条目不多，线性查找距离最近的一项，代价在微秒级
+    auto best = m_entries.end();
+    int bestDist = m_tolerance + 1;
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->kind != kind || !sameArea(it->key, key) || it->variant != variant) continue;
+        const int d = distance(it->key, key);
+        if (d < bestDist) {
+            bestDist = d;
+            best = it;
+            if (d == 0) break;
+        }
+    }
+    if (best == m_entries.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    m_entries.splice(m_entries.begin(), m_entries, best);
+    return &m_entries.front();
+}
+
+ResultCache::Entry &ResultCache::insert(const Key &key, Kind kind, const QString &variant)
+{
+    // 同一画面已有条目时覆盖，不计入命中统计
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+        if (it->kind == kind && sameArea(it->key, key) && it->variant == variant
+            && distance(it->key, key) <= m_tolerance) {
+            it->key = key;
+            m_entries.splice(m_entries.begin(), m_entries, it);
+            return m_entries.front();
+        }
+    }
+    m_entries.push_front(Entry{key, kind, variant});
+    while (int(m_entries.size()) > m_capacity) {
+        m_entries.pop_back();
+        m_evictions++;
+    }
+    return m_entries.front();
+}
+
+bool ResultCache::lookupTemplate(const Key &key, const QString &variant, TemplateResult *out)
+{
+    QMutexLocker lock(&m_mutex);
+    const Entry *e = find(key, Kind::Template, variant);
+    if (e && out) *out = e->tmpl;
+    return e != nullptr;
+}
+
+bool ResultCache::lookupOcr(const Key &key, const QString &variant, OcrResult *out)
+{
+    QMutexLocker lock(&m_mutex);
+    const Entry *e = find(key, Kind::Ocr, variant);
+    if (e && out) *out = e->ocr;
+    return e != nullptr;
+}
+
+void ResultCache::storeTemplate(const Key &key, const QString &variant, const TemplateResult &r)
+{
+    if (key.frameSize.isEmpty()) return;
+    QMutexLocker lock(&m_mutex);
+    insert(key, Kind::Template, variant).tmpl = r;
+}
+
+void ResultCache::storeOcr(const Key &key, const QString &variant, const OcrResult &r)
+{
+    // 被取消的结果不完整，不缓存
+    if (key.frameSize.isEmpty() || r.cancelled) return;
+    QMutexLocker lock(&m_mutex);
+    insert(key, Kind::Ocr, variant).ocr = r;
+}
+
+ResultCache::Stats ResultCache::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    Stats s;
+    s.hits = m_hits;
+    s.misses = m_misses;
+    s.evictions = m_evictions;
+    s.size = int(m_entries.size());
+    s.capacity = m_capacity;
+    return s;
+}
+
+QString ResultCache::statsSummary() const
+{
+    const Stats s = stats();
+    const qint64 total = s.hits + s.misses;
+    return QString("结果缓存: 命中=%1 未命中=%2 命中率=%3% 淘汰=%4 条目=%5/%6")
+        .arg(s.hits).arg(s.misses).arg(total > 0 ? 100.0 * s.hits / total : 0.0, 0, 'f', 1)
+        .arg(s.evictions).arg(s.size).arg(s.capacity);
+}
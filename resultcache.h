@@ -0,0 +1,79 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <array>
+#include <list>
+
+#include "detector.h"
+#include "frame.h"
+
+// 识别结果缓存：游戏界面在少数几个画面间切换，见过的画面不必再跑一遍模板匹配与 OCR。
+// 以缩小后画面的差分哈希（dHash，256 位）为键，汉明距离不超过 tolerance 即视为同一画面；
+// 整帧哈希每位覆盖上百像素，标签出现或移动只改变一两位，因此默认只接受完全相同的哈希，
+// 调用方还应对命中结果做廉价复核（见 DetectRequest）。容量有限，按最近使用淘汰。可在多个线程中并发使用。
+class ResultCache
+{
+public:
+    struct Key {
+        std::array<quint64, 4> bits{};
+        QSize frameSize;            // 分辨率不同的画面不互相命中
+        QRect region;               // 取哈希的区域（全图坐标），区域不同的键不互相命中
+    };
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+        int size = 0;
+        int capacity = 0;
+    };
+
+    explicit ResultCache(int capacity = 64, int tolerance = 0);
+
+    // roi 有效时只对该区域取哈希。取自帧共享的 1/8 缩小灰度图（与帧变化检测同一平面），
+    // 区域在其中不足 17x16 时才改为只转换区域内的原始像素
+    static Key hash(const Frame &frame, const QRect &roi = QRect());
+    static int distance(const Key &a, const Key &b);
+    static bool sameArea(const Key &a, const Key &b) { return a.frameSize == b.frameSize && a.region == b.region; }
+
+    void setCapacity(int capacity);
+    void setTolerance(int bits) { QMutexLocker lock(&m_mutex); m_tolerance = qMax(0, bits); }
+    void clear();
+
+    // variant 区分同一画面下不同的识别参数，例如匹配模式、OCR 调度方式
+    bool lookupTemplate(const Key &key, const QString &variant, TemplateResult *out);
+    bool lookupOcr(const Key &key, const QString &variant, OcrResult *out);
+    void storeTemplate(const Key &key, const QString &variant, const TemplateResult &r);
+    void storeOcr(const Key &key, const QString &variant, const OcrResult &r);
+
+    Stats stats() const;
+    QString statsSummary() const;
+
+private:
+    enum class Kind { Template, Ocr };
+    struct Entry {
+        Key key;
+        Kind kind;
+        QString variant;
+        TemplateResult tmpl{QPoint(-1, -1), 0.0, QSize()};
+        OcrResult ocr;
+    };
+
+    // 命中时移到表头并返回；调用时需持有锁
+    Entry *find(const Key &key, Kind kind, const QString &variant);
+    Entry &insert(const Key &key, Kind kind, const QString &variant);
+
+    mutable QMutex m_mutex;
+    std::list<Entry> m_entries;     // 表头为最近使用
+    int m_capacity;
+    int m_tolerance;
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+    qint64 m_evictions = 0;
+};
+
+#endif // RESULTCACHE_H
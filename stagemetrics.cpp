@@ -0,0 +1,205 @@
+#include "stagemetrics.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram()
+{
+    for (std::atomic<quint64> &b : m_buckets) b.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketIndex(quint64 us)
+{
+    if (us < quint64(kSubCount)) return int(us);
+    int msb = 63;
+    while (!(us >> msb)) --msb;
+    if (msb >= kMaxBits) return kBucketCount - 1;
+    const int shift = msb - kSubBits;
+    return (shift + 1) * kSubCount + int((us >> shift) - kSubCount);
+}
+
+quint64 LatencyHistogram::bucketLow(int index)
+{
+    if (index < kSubCount) return quint64(index);
+    const int shift = index / kSubCount - 1;
+    return quint64(index % kSubCount + kSubCount) << shift;
+}
+
+quint64 LatencyHistogram::bucketHigh(int index)
+{
+    if (index < kSubCount) return quint64(index);
+    const int shift = index / kSubCount - 1;
+    return (quint64(index % kSubCount + kSubCount + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(quint64 us)
+{
+    m_buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(us, std::memory_order_relaxed);
+    quint64 cur = m_min.load(std::memory_order_relaxed);
+    while (us < cur && !m_min.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {}
+    cur = m_max.load(std::memory_order_relaxed);
+    while (us > cur && !m_max.compare_exchange_weak(cur, us, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    // 各计数分别读取，并发写入时快照只是近似一致，对统计足够；
+    // 总数由各桶求和得出，与百分位计算所用的桶保持一致
+    Snapshot s;
+    s.buckets.resize(kBucketCount);
+    quint64 total = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        s.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += s.buckets[i];
+    }
+    s.count = total;
+    s.sumUs = m_sum.load(std::memory_order_relaxed);
+    s.minUs = total ? m_min.load(std::memory_order_relaxed) : 0;
+    s.maxUs = m_max.load(std::memory_order_relaxed);
+    return s;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::atomic<quint64> &b : m_buckets) b.store(0, std::memory_order_relaxed);
+    m_sum = 0;
+    m_min = ~quint64(0);
+    m_max = 0;
+}
+
+double LatencyHistogram::Snapshot::percentileUs(double q) const
+{
+    if (!count) return 0.0;
+    const quint64 rank = qMax<quint64>(1, quint64(std::ceil(q * count)));
+    quint64 seen = 0;
+    for (int i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            const double mid = (bucketLow(i) + bucketHigh(i)) / 2.0;
+            // 桶中点可能落在实际范围之外，夹到 min/max
+            return qBound(double(minUs), mid, double(maxUs));
+        }
+    }
+    return double(maxUs);
+}
+
+namespace StageMetrics {
+
+namespace {
+
+LatencyHistogram g_histograms[int(Stage::Count)];
+
+const double kQuantiles[] = { 0.5, 0.9, 0.99 };
+
+} // namespace
+
+const char *stageName(Stage stage)
+{
+    static const char *names[] = {
+        "capture", "convert_bgr", "convert_gray_pix", "template_scale", "template_match",
+        "tessdata_resolve", "tess_init", "text_detect", "ocr_recognize", "ocr_iterate", "ocr_find", "render"
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == int(Stage::Count), "stage names out of sync");
+    return names[int(stage)];
+}
+
+void record(Stage stage, quint64 us)
+{
+    g_histograms[int(stage)].record(us);
+}
+
+LatencyHistogram::Snapshot snapshot(Stage stage)
+{
+    return g_histograms[int(stage)].snapshot();
+}
+
+void reset()
+{
+    for (LatencyHistogram &h : g_histograms) h.reset();
+}
+
+QString toJson()
+{
+    QJsonArray stages;
+    for (int i = 0; i < int(Stage::Count); ++i) {
+        const LatencyHistogram::Snapshot s = g_histograms[i].snapshot();
+        QJsonObject o{
+            {"stage", stageName(Stage(i))},
+            {"count", double(s.count)},
+            {"sum_ms", s.sumUs / 1000.0},
+            {"mean_ms", s.meanUs() / 1000.0},
+            {"min_ms", s.minUs / 1000.0},
+            {"max_ms", s.maxUs / 1000.0},
+            {"p50_ms", s.percentileUs(0.50) / 1000.0},
+            {"p90_ms", s.percentileUs(0.90) / 1000.0},
+            {"p99_ms", s.percentileUs(0.99) / 1000.0},
+        };
+        // 非空桶：[下界 µs, 上界 µs, 计数]，便于离线合并或重算分位数
+        QJsonArray buckets;
+        for (int b = 0; b < s.buckets.size(); ++b) {
+            if (!s.buckets[b]) continue;
+            buckets.append(QJsonArray{ double(LatencyHistogram::bucketLow(b)),
+                                       double(LatencyHistogram::bucketHigh(b)), double(s.buckets[b]) });
+        }
+        o["buckets_us"] = buckets;
+        stages.append(o);
+    }
+    const QJsonObject doc{
+        {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {"stages", stages}
+    };
+    return QString::fromUtf8(QJsonDocument(doc).toJson());
+}
+
+QString toPrometheus()
+{
+    QString out;
+    out += "# HELP dldl_stage_latency_seconds Per-stage detection latency.\n";
+    out += "# TYPE dldl_stage_latency_seconds summary\n";
+    for (int i = 0; i < int(Stage::Count); ++i) {
+        const LatencyHistogram::Snapshot s = g_histograms[i].snapshot();
+        const QString stage = QString::fromLatin1(stageName(Stage(i)));
+        for (double q : kQuantiles) {
+            out += QString("dldl_stage_latency_seconds{stage=\"%1\",quantile=\"%2\"} %3\n")
+                       .arg(stage).arg(q).arg(s.percentileUs(q) / 1e6, 0, 'g', 6);
+        }
+        out += QString("dldl_stage_latency_seconds_sum{stage=\"%1\"} %2\n").arg(stage).arg(s.sumUs / 1e6, 0, 'g', 9);
+        out += QString("dldl_stage_latency_seconds_count{stage=\"%1\"} %2\n").arg(stage).arg(s.count);
+    }
+    return out;
+}
+
+QString summaryText()
+{
+    QString out = QString("%1 %2 %3 %4 %5 %6\n").arg("阶段", -18).arg("次数", 8).arg("p50ms", 10)
+                      .arg("p90ms", 10).arg("p99ms", 10).arg("maxms", 10);
+    for (int i = 0; i < int(Stage::Count); ++i) {
+        const LatencyHistogram::Snapshot s = g_histograms[i].snapshot();
+        out += QString("%1 %2 %3 %4 %5 %6\n").arg(QString::fromLatin1(stageName(Stage(i))), -18)
+                   .arg(s.count, 8)
+                   .arg(s.percentileUs(0.50) / 1000.0, 10, 'f', 2)
+                   .arg(s.percentileUs(0.90) / 1000.0, 10, 'f', 2)
+                   .arg(s.percentileUs(0.99) / 1000.0, 10, 'f', 2)
+                   .arg(s.maxUs / 1000.0, 10, 'f', 2);
+    }
+    return out;
+}
+
+bool dumpToFile(const QString &path, QString *error)
+{
+    const bool prom = path.endsWith(".prom", Qt::CaseInsensitive) || path.endsWith(".txt", Qt::CaseInsensitive);
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (error) *error = f.errorString();
+        return false;
+    }
+    f.write((prom ? toPrometheus() : toJson()).toUtf8());
+    return true;
+}
+
+} // namespace StageMetrics
@@ -0,0 +1,95 @@
+#ifndef STAGEMETRICS_H
+#define STAGEMETRICS_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// 识别各阶段
+enum class Stage {
+    Capture,            // 窗口截图
+    ConvertBgr,         // QImage -> BGR Mat
+    ConvertGrayPix,     // QImage -> 灰度 Pix
+    TemplateScale,      // 单个尺度的 matchTemplate
+    TemplateMatch,      // 一次完整的多尺度匹配
+    TessdataResolve,    // 查找模型文件
+    TessInit,           // TessBaseAPI::Init
+    TextDetect,         // 候选文本行检测
+    OcrRecognize,       // GetUTF8Text / Recognize
+    OcrIterate,         // 遍历识别结果查找标签
+    OcrFind,            // 一次完整的 OCR 查找
+    Render,             // 截图预览与标记绘制
+    Count
+};
+
+// HDR 风格的对数-线性直方图（微秒）
+// 每个 2 的幂区间再均分为 32 个子桶，相对误差约 3%，覆盖 0 ~ 2^40 µs。
+// record() 只做原子加，可在任意线程无锁调用。
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBits = 5;
+    static constexpr int kSubCount = 1 << kSubBits;
+    static constexpr int kMaxBits = 40;
+    static constexpr int kBucketCount = (kMaxBits - kSubBits + 1) * kSubCount;
+
+    struct Snapshot {
+        quint64 count = 0;
+        quint64 sumUs = 0;
+        quint64 minUs = 0;
+        quint64 maxUs = 0;
+        QVector<quint64> buckets;
+        // q 取 0~1，返回所在桶的中点（微秒）
+        double percentileUs(double q) const;
+        double meanUs() const { return count ? double(sumUs) / count : 0.0; }
+    };
+
+    LatencyHistogram();
+    void record(quint64 us);
+    Snapshot snapshot() const;
+    void reset();
+
+    static int bucketIndex(quint64 us);
+    static quint64 bucketLow(int index);
+    static quint64 bucketHigh(int index);
+
+private:
+    std::atomic<quint64> m_buckets[kBucketCount];
+    std::atomic<quint64> m_sum{0};
+    std::atomic<quint64> m_min{~quint64(0)};
+    std::atomic<quint64> m_max{0};
+};
+
+// 全进程的分阶段耗时统计
+namespace StageMetrics {
+
+const char *stageName(Stage stage);
+void record(Stage stage, quint64 us);
+LatencyHistogram::Snapshot snapshot(Stage stage);
+void reset();
+
+QString toJson();
+QString toPrometheus();
+// 文本摘要（每阶段 count / p50 / p90 / p99 / max），供界面面板显示
+QString summaryText();
+// 按扩展名选择格式：.prom / .txt 为 Prometheus 文本，其余为 JSON
+bool dumpToFile(const QString &path, QString *error = nullptr);
+
+} // namespace StageMetrics
+
+// 作用域计时：析构时把耗时记入对应阶段
+class StageTimer
+{
+public:
+    explicit StageTimer(Stage stage) : m_stage(stage) { m_timer.start(); }
+    ~StageTimer() { StageMetrics::record(m_stage, quint64(m_timer.nsecsElapsed() / 1000)); }
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+    Stage m_stage;
+    QElapsedTimer m_timer;
+};
+
+#endif // STAGEMETRICS_H
@@ -0,0 +1,364 @@
+#include "templatematcher.h"
+
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <opencv2/imgproc.hpp>
+
+#include "stagemetrics.h"
+
+namespace {
+
+// 单次匹配：有掩膜用 TM_CCORR_NORMED，否则 TM_CCOEFF_NORMED；返回最大得分
+double matchOne(const cv::Mat &src, const cv::Mat &templ, const cv::Mat &mask, cv::Point *locOut)
+{
+    StageTimer stage(Stage::TemplateScale);
+    cv::Mat result;
+    if (!mask.empty()) cv::matchTemplate(src, templ, result, cv::TM_CCORR_NORMED, mask);
+    else cv::matchTemplate(src, templ, result, cv::TM_CCOEFF_NORMED);
+    double maxVal = 0.0; cv::Point maxLoc;
+    cv::minMaxLoc(result, nullptr, &maxVal, nullptr, &maxLoc);
+    if (locOut) *locOut = maxLoc;
+    return maxVal;
+}
+
+struct Candidate {
+    double score;
+    size_t level;
+    cv::Point loc;  // 全分辨率坐标
+    bool refined;   // 已在全分辨率上得到结果，无需精修
+};
+
+} // namespace
+
+TemplateMatcher::TemplateMatcher(LogFn log)
+    : m_log(std::move(log))
+{
+    setSearchParams(m_search);
+}
+
+void TemplateMatcher::setSearchParams(const SearchParams &p)
+{
+    m_search = p;
+    m_pool.setMaxThreadCount(p.threads > 0 ? p.threads : QThread::idealThreadCount());
+}
+
+QString TemplateMatcher::modeName(Mode mode)
+{
+    switch (mode) {
+    case Mode::Exhaustive: return QStringLiteral("exhaustive");
+    case Mode::CoarseToFine: return QStringLiteral("coarse-to-fine");
+    case Mode::Compare: return QStringLiteral("compare");
+    case Mode::Features: return QStringLiteral("features");
+    }
+    return QString();
+}
+
+TemplateMatcher::CompareStats TemplateMatcher::compareStats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+TemplateMatcher::Result TemplateMatcher::match(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl, Mode mode,
+                                               const CancelFn &cancel)
+{
+    if (!tmpl) return Result();
+    if (mode == Mode::Exhaustive) return matchExhaustive(src3, *tmpl, cancel);
+    if (mode == Mode::CoarseToFine) return matchCoarseToFine(src3, tmpl, cancel);
+    if (mode == Mode::Features) return matchFeatures(src3, tmpl, cancel);
+
+    Result ex = matchExhaustive(src3, *tmpl, cancel);
+    if (ex.cancelled) return ex;
+    Result cf = matchCoarseToFine(src3, tmpl, cancel);
+    if (cf.cancelled) return cf;
+    const bool agree = ex.valid() && cf.valid() && ex.scale == cf.scale
+            && std::abs(ex.loc.x - cf.loc.x) <= 2 && std::abs(ex.loc.y - cf.loc.y) <= 2;
+
+    QMutexLocker lock(&m_mutex);
+    m_stats.runs++;
+    if (agree) m_stats.agree++;
+    m_stats.exhaustiveMs += ex.elapsedMs;
+    m_stats.coarseMs += cf.elapsedMs;
+    m_stats.maxScoreDelta = std::max(m_stats.maxScoreDelta, ex.score - cf.score);
+    const CompareStats st = m_stats;
+    lock.unlock();
+
+    log(QString("[对比] 穷举 score=%1 pos=(%2,%3) scale=%4 %5ms | 粗到细 score=%6 pos=(%7,%8) scale=%9 %10ms | %11")
+        .arg(ex.score, 0, 'f', 4).arg(ex.loc.x).arg(ex.loc.y).arg(ex.scale, 0, 'f', 2).arg(ex.elapsedMs, 0, 'f', 1)
+        .arg(cf.score, 0, 'f', 4).arg(cf.loc.x).arg(cf.loc.y).arg(cf.scale, 0, 'f', 2).arg(cf.elapsedMs, 0, 'f', 1)
+        .arg(agree ? "一致" : "不一致"));
+    log(QString("[对比] 累计 %1 次: 一致率=%2% 平均耗时 穷举=%3ms 粗到细=%4ms 加速比=%5x 最大得分损失=%6")
+        .arg(st.runs).arg(100.0 * st.agree / st.runs, 0, 'f', 1)
+        .arg(st.exhaustiveMs / st.runs, 0, 'f', 1).arg(st.coarseMs / st.runs, 0, 'f', 1)
+        .arg(st.coarseMs > 0 ? st.exhaustiveMs / st.coarseMs : 0.0, 0, 'f', 2)
+        .arg(st.maxScoreDelta, 0, 'f', 4));
+    return ex;
+}
+
+TemplateMatcher::Result TemplateMatcher::matchExhaustive(const cv::Mat &src3, const TemplateRegistry::Pyramid &tmpl,
+                                                         const CancelFn &cancel) const
+{
+    QElapsedTimer timer; timer.start();
+    const int n = (int)tmpl.levels.size();
+    const double goodEnough = m_search.goodEnough;
+
+    struct LevelScore { bool done = false; double score = -1.0; cv::Point loc; };
+    std::vector<LevelScore> scores(n);
+    // 第一个达到阈值的尺度下标；大于它的尺度尚未开始的直接跳过
+    std::atomic<int> cutoff(n);
+    // 取消后尚未开始的尺度与 cutoff 之后的尺度一样直接跳过
+    std::atomic<bool> cancelled(false);
+
+    auto runLevel = [&](int i) {
+        if (i > cutoff.load(std::memory_order_acquire) || cancelled.load(std::memory_order_relaxed)) return;
+        if (cancel && cancel()) {
+            cancelled = true;
+            return;
+        }
+        const TemplateRegistry::Level &lv = tmpl.levels[i];
+        if (lv.bgr.cols > src3.cols || lv.bgr.rows > src3.rows) return;
+        LevelScore &r = scores[i];
+        r.score = matchOne(src3, lv.bgr, lv.mask, &r.loc);
+        r.done = true;
+        if (goodEnough > 0.0 && r.score >= goodEnough) {
+            int cur = cutoff.load(std::memory_order_relaxed);
+            while (i < cur && !cutoff.compare_exchange_weak(cur, i, std::memory_order_acq_rel)) {}
+        }
+    };
+
+    if (m_pool.maxThreadCount() <= 1 || n <= 1) {
+        for (int i = 0; i < n && i <= cutoff.load() && !cancelled; ++i) runLevel(i);
+    } else {
+        QSemaphore finished;
+        for (int i = 0; i < n; ++i) {
+            m_pool.start([&runLevel, &finished, i]() {
+                runLevel(i);
+                finished.release();
+            });
+        }
+        finished.acquire(n);
+    }
+
+    // 按尺度顺序汇总：只取严格更大的得分，平分时保留靠前的尺度，与串行循环一致
+    Result best;
+    if (cancelled) {
+        best.cancelled = true;
+        best.elapsedMs = timer.nsecsElapsed() / 1e6;
+        return best;
+    }
+    const int last = std::min(cutoff.load(), n - 1);
+    for (int i = 0; i <= last; ++i) {
+        const TemplateRegistry::Level &lv = tmpl.levels[i];
+        const LevelScore &r = scores[i];
+        if (!r.done) {
+            if (tracing())
+                log(QString("跳过尺度%1：模板大于截图 (%2x%3)>").arg(lv.scale,0,'f',1).arg(lv.bgr.cols).arg(lv.bgr.rows),
+                    LogLevel::Debug);
+            continue;
+        }
+        if (tracing())
+            log(QString("尺度%1 匹配得分=%2 位置=(%3,%4) 模板(%5x%6)")
+                .arg(lv.scale,0,'f',1).arg(r.score,0,'f',4).arg(r.loc.x).arg(r.loc.y).arg(lv.bgr.cols).arg(lv.bgr.rows),
+                LogLevel::Debug);
+        if (r.score > best.score) { best.score = r.score; best.loc = r.loc; best.scale = lv.scale; best.size = lv.bgr.size(); }
+    }
+    if (last < n - 1) {
+        log(QString("尺度%1 得分达到阈值%2，取消其余 %3 个尺度")
+            .arg(tmpl.levels[last].scale,0,'f',1).arg(goodEnough,0,'f',3).arg(n - 1 - last));
+    }
+    best.elapsedMs = timer.nsecsElapsed() / 1e6;
+    return best;
+}
+
+std::shared_ptr<const TemplateMatcher::CoarseSet> TemplateMatcher::coarseSetFor(const TemplateRegistry::PyramidPtr &tmpl, double factor)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_coarseSet && m_coarseSet->source == tmpl && m_coarseSet->factor == factor) return m_coarseSet;
+
+    auto set = std::make_shared<CoarseSet>();
+    set->source = tmpl;
+    set->factor = factor;
+    for (const TemplateRegistry::Level &lv : tmpl->levels) {
+        cv::Size sz(cvRound(lv.bgr.cols * factor), cvRound(lv.bgr.rows * factor));
+        cv::Mat bgr, mask;
+        // 降采样后过小的模板不参与粗搜索，直接在全分辨率上匹配
+        if (sz.width >= 4 && sz.height >= 4) {
+            cv::resize(lv.bgr, bgr, sz, 0, 0, cv::INTER_AREA);
+            if (!lv.mask.empty()) {
+                cv::resize(lv.mask, mask, sz, 0, 0, cv::INTER_AREA);
+                cv::threshold(mask, mask, 127, 255, cv::THRESH_BINARY);
+            }
+        }
+        set->bgr.push_back(bgr);
+        set->mask.push_back(mask);
+    }
+    m_coarseSet = set;
+    return set;
+}
+
+TemplateMatcher::Result TemplateMatcher::matchCoarseToFine(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl,
+                                                           const CancelFn &cancel)
+{
+    QElapsedTimer timer; timer.start();
+    Result best;
+    if (!tmpl) return best;
+    auto cancelled = [&]() {
+        if (!cancel || !cancel()) return false;
+        best = Result();
+        best.cancelled = true;
+        best.elapsedMs = timer.nsecsElapsed() / 1e6;
+        return true;
+    };
+    const CoarseParams params = m_coarse;
+    const double f = std::clamp(params.factor, 0.05, 1.0);
+    std::shared_ptr<const CoarseSet> coarse = coarseSetFor(tmpl, f);
+
+    cv::Mat srcCoarse;
+    cv::resize(src3, srcCoarse, cv::Size(cvRound(src3.cols * f), cvRound(src3.rows * f)), 0, 0, cv::INTER_AREA);
+
+    // 粗搜索：每个尺度取 top-k 峰值（非极大值抑制），再全局保留 top-k。
+    // 跳过粗搜索的尺度已是全分辨率得分，与降采样得分不可比，不参与 top-k 截断，最后与精修结果一起比较
+    std::vector<Candidate> candidates;
+    std::vector<Candidate> exact;
+    for (size_t i = 0; i < tmpl->levels.size(); ++i) {
+        if (cancelled()) return best;
+        const TemplateRegistry::Level &lv = tmpl->levels[i];
+        if (lv.bgr.cols > src3.cols || lv.bgr.rows > src3.rows) continue;
+        const cv::Mat &templC = coarse->bgr[i];
+        if (templC.empty() || templC.cols > srcCoarse.cols || templC.rows > srcCoarse.rows) {
+            cv::Point loc;
+            double score = matchOne(src3, lv.bgr, lv.mask, &loc);
+            exact.push_back({score, i, loc, true});
+            continue;
+        }
+        cv::Mat result;
+        if (!coarse->mask[i].empty()) cv::matchTemplate(srcCoarse, templC, result, cv::TM_CCORR_NORMED, coarse->mask[i]);
+        else cv::matchTemplate(srcCoarse, templC, result, cv::TM_CCOEFF_NORMED);
+        for (int k = 0; k < params.topK; ++k) {
+            double maxVal = 0.0; cv::Point maxLoc;
+            cv::minMaxLoc(result, nullptr, &maxVal, nullptr, &maxLoc);
+            if (maxVal <= -1.0) break;
+            candidates.push_back({maxVal, i, cv::Point(cvRound(maxLoc.x / f), cvRound(maxLoc.y / f)), false});
+            // 抑制峰值周围一个模板大小的区域，避免候选挤在同一处
+            cv::Rect sup(maxLoc.x - templC.cols / 2, maxLoc.y - templC.rows / 2, templC.cols, templC.rows);
+            sup &= cv::Rect(0, 0, result.cols, result.rows);
+            result(sup).setTo(-2.0);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+    if ((int)candidates.size() > params.topK) candidates.resize(std::max(1, params.topK));
+    candidates.insert(candidates.end(), exact.begin(), exact.end());
+
+    // 精修：候选周围的小 ROI 内做全分辨率匹配
+    const int pad = params.refineMargin + (int)std::ceil(1.0 / f);
+    const cv::Rect srcRect(0, 0, src3.cols, src3.rows);
+    for (const Candidate &c : candidates) {
+        const TemplateRegistry::Level &lv = tmpl->levels[c.level];
+        cv::Point loc = c.loc;
+        double score = c.score;
+        if (!c.refined) {
+            if (cancelled()) return best;
+            cv::Rect roi(c.loc.x - pad, c.loc.y - pad, lv.bgr.cols + 2 * pad, lv.bgr.rows + 2 * pad);
+            roi &= srcRect;
+            if (roi.width < lv.bgr.cols || roi.height < lv.bgr.rows) continue;
+            score = matchOne(src3(roi), lv.bgr, lv.mask, &loc);
+            loc += roi.tl();
+        }
+        if (tracing())
+            log(QString("[粗到细] 尺度%1 粗得分=%2 精修得分=%3 位置=(%4,%5)")
+                .arg(lv.scale, 0, 'f', 1).arg(c.score, 0, 'f', 4).arg(score, 0, 'f', 4).arg(loc.x).arg(loc.y),
+                LogLevel::Debug);
+        if (score > best.score) { best.score = score; best.loc = loc; best.scale = lv.scale; best.size = lv.bgr.size(); }
+    }
+    best.elapsedMs = timer.nsecsElapsed() / 1e6;
+    return best;
+}
+
+TemplateMatcher::Result TemplateMatcher::matchFeatures(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl,
+                                                       const CancelFn &cancel)
+{
+    QElapsedTimer timer; timer.start();
+    Result best;
+    if (!tmpl || tmpl->levels.empty()) return best;
+    // 特征估计是一次不可中断的调用，只在其前后检查取消
+    auto cancelled = [&]() {
+        if (!cancel || !cancel()) return false;
+        best.cancelled = true;
+        best.elapsedMs = timer.nsecsElapsed() / 1e6;
+        return true;
+    };
+    if (cancelled()) return best;
+    const FeatureMatcher::Estimate est = m_features.estimate(src3, tmpl);
+    if (tracing())
+        log(QString("[特征] %1 模板关键点=%2 匹配=%3 内点=%4 尺度=%5 角度=%6")
+            .arg(FeatureMatcher::kindName(m_features.params().kind)).arg(est.templateKeypoints).arg(est.matches)
+            .arg(est.inliers).arg(est.scale, 0, 'f', 3).arg(est.angleDeg, 0, 'f', 1), LogLevel::Debug);
+    if (!est.found) {
+        best.elapsedMs = timer.nsecsElapsed() / 1e6;
+        return best;
+    }
+    if (cancelled()) return best;
+
+    // 以最接近估计尺度的一层为基准缩放到估计尺度，在估计框附近做一次掩膜匹配，得分与穷举模式可比
+    const TemplateRegistry::Level *base = &tmpl->levels.front();
+    for (const TemplateRegistry::Level &lv : tmpl->levels) {
+        if (std::abs(lv.scale - est.scale) < std::abs(base->scale - est.scale)) base = &lv;
+    }
+    const double k = est.scale / base->scale;
+    const cv::Size sz(cvRound(base->bgr.cols * k), cvRound(base->bgr.rows * k));
+    const int margin = m_coarse.refineMargin + 4;
+    const cv::Rect roi = cv::Rect(est.box.x - margin, est.box.y - margin,
+                                  est.box.width + 2 * margin, est.box.height + 2 * margin)
+                         & cv::Rect(0, 0, src3.cols, src3.rows);
+    best.scale = est.scale;
+    if (sz.width >= 4 && sz.height >= 4 && sz.width <= roi.width && sz.height <= roi.height) {
+        cv::Mat bgr, mask;
+        cv::resize(base->bgr, bgr, sz, 0, 0, k < 1.0 ? cv::INTER_AREA : cv::INTER_LINEAR);
+        if (!base->mask.empty()) {
+            cv::resize(base->mask, mask, sz, 0, 0, cv::INTER_NEAREST);
+        }
+        cv::Point loc;
+        best.score = matchOne(src3(roi), bgr, mask, &loc);
+        best.loc = roi.tl() + loc;
+        best.size = sz;
+    } else {
+        // 旋转较大时外接矩形装不下缩放后的模板，无法给出与其他模式同一量纲的得分，按未匹配处理，
+        // 以免内点比例混入 ocrRoiMinScore / trackMinScore 等阈值判断
+        if (tracing())
+            log(QString("[特征] 估计框(%1x%2)装不下缩放后的模板(%3x%4)，视为未匹配")
+                .arg(est.box.width).arg(est.box.height).arg(sz.width).arg(sz.height), LogLevel::Debug);
+        best = Result();
+    }
+    best.elapsedMs = timer.nsecsElapsed() / 1e6;
+    return best;
+}
+
+TemplateMatcher::Result TemplateMatcher::matchNear(const cv::Mat &window3, const TemplateRegistry::Pyramid &tmpl,
+                                                   double scale, int levelRadius) const
+{
+    QElapsedTimer timer; timer.start();
+    Result best;
+    const int n = (int)tmpl.levels.size();
+    int center = -1;
+    for (int i = 0; i < n; ++i) {
+        if (center < 0 || std::abs(tmpl.levels[i].scale - scale) < std::abs(tmpl.levels[center].scale - scale)) center = i;
+    }
+    if (center < 0) return best;
+    // 窗口很小，几个尺度串行即可
+    for (int i = std::max(0, center - levelRadius); i <= std::min(n - 1, center + levelRadius); ++i) {
+        const TemplateRegistry::Level &lv = tmpl.levels[i];
+        if (lv.bgr.cols > window3.cols || lv.bgr.rows > window3.rows) continue;
+        cv::Point loc;
+        const double score = matchOne(window3, lv.bgr, lv.mask, &loc);
+        if (score > best.score) { best.score = score; best.loc = loc; best.scale = lv.scale; best.size = lv.bgr.size(); }
+    }
+    best.elapsedMs = timer.nsecsElapsed() / 1e6;
+    return best;
+}
@@ -0,0 +1,111 @@
+#ifndef TEMPLATEMATCHER_H
+#define TEMPLATEMATCHER_H
+
+#include <QString>
+#include <QMutex>
+#include <QThreadPool>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "featurematcher.h"
+#include "logsink.h"
+#include "templateregistry.h"
+
+// 多尺度模板匹配
+// Exhaustive：每个尺度在全分辨率截图上做掩膜 TM_CCORR_NORMED，各尺度分发到线程池并行
+// CoarseToFine：先在降采样截图上搜索，再只在 top-k 候选附近的小 ROI 内全分辨率精修
+// Compare：两者都跑，记录精度与耗时差异，返回穷举结果
+// Features：特征点匹配估计位置与尺度，再在估计尺度下做一次局部 matchTemplate 得到可比的得分
+class TemplateMatcher
+{
+public:
+    using LogFn = ::LogFn;
+    // 匹配过程中在尺度之间、候选之间调用，返回 true 时放弃尚未开始的工作（与 Detector::CancelFn 相同）
+    using CancelFn = std::function<bool()>;
+
+    enum class Mode { Exhaustive, CoarseToFine, Compare, Features };
+
+    struct Result {
+        cv::Point loc{-1, -1};
+        double score = -1.0;    // 小于 0 表示没有任何尺度可匹配
+        double scale = 1.0;
+        cv::Size size;
+        double elapsedMs = 0.0;
+        bool cancelled = false; // 被取消时结果无效
+        bool valid() const { return score >= 0.0 && !cancelled; }
+    };
+
+    struct CoarseParams {
+        double factor = 0.5;    // 粗搜索的降采样比例
+        int topK = 3;           // 进入精修的候选数
+        int refineMargin = 4;   // 精修 ROI 在候选周围额外扩展的像素（全分辨率）
+    };
+
+    struct SearchParams {
+        // 按尺度顺序第一个达到该得分的尺度之后的尺度全部取消，<=0 关闭提前终止
+        double goodEnough = 0.0;
+        int threads = 0;        // 0 表示使用 CPU 核数，1 表示串行
+    };
+
+    struct CompareStats {
+        int runs = 0;
+        int agree = 0;              // 位置误差 <=2px 且尺度相同的次数
+        double exhaustiveMs = 0.0;  // 累计耗时
+        double coarseMs = 0.0;
+        double maxScoreDelta = 0.0; // 穷举得分 - 粗到细得分 的最大值
+    };
+
+    explicit TemplateMatcher(LogFn log = LogFn());
+
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+    void setSearchParams(const SearchParams &p);
+    SearchParams searchParams() const { return m_search; }
+    void setCoarseParams(const CoarseParams &p) { m_coarse = p; }
+    CoarseParams coarseParams() const { return m_coarse; }
+
+    // src3 为 BGR 截图；cancel 置位后正在计算的尺度会跑完，未开始的尺度与精修直接跳过
+    Result match(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl, Mode mode,
+                 const CancelFn &cancel = CancelFn());
+    Result matchExhaustive(const cv::Mat &src3, const TemplateRegistry::Pyramid &tmpl,
+                           const CancelFn &cancel = CancelFn()) const;
+    Result matchCoarseToFine(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl,
+                             const CancelFn &cancel = CancelFn());
+    Result matchFeatures(const cv::Mat &src3, const TemplateRegistry::PyramidPtr &tmpl,
+                         const CancelFn &cancel = CancelFn());
+    // 跟踪：只在 window3（截图中的局部 BGR 区域）内匹配与 scale 最接近的层及其前后 levelRadius 层，
+    // loc 为 window3 内坐标
+    Result matchNear(const cv::Mat &window3, const TemplateRegistry::Pyramid &tmpl, double scale, int levelRadius = 1) const;
+
+    FeatureMatcher &features() { return m_features; }
+
+    CompareStats compareStats() const;
+    static QString modeName(Mode mode);
+
+private:
+    // 与金字塔对应的降采样模板，金字塔或比例变化时重建
+    struct CoarseSet {
+        TemplateRegistry::PyramidPtr source;
+        double factor = 0.0;
+        std::vector<cv::Mat> bgr;
+        std::vector<cv::Mat> mask;
+    };
+    std::shared_ptr<const CoarseSet> coarseSetFor(const TemplateRegistry::PyramidPtr &tmpl, double factor);
+
+    // 调试级追踪开启时才值得格式化消息
+    bool tracing() const { return m_log && LogSink::enabled(LogLevel::Debug); }
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    SearchParams m_search;
+    CoarseParams m_coarse;
+    mutable QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    std::shared_ptr<const CoarseSet> m_coarseSet;
+    FeatureMatcher m_features;
+    CompareStats m_stats;
+    LogFn m_log;
+};
+
+#endif // TEMPLATEMATCHER_H
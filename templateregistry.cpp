@@ -0,0 +1,142 @@
+#include "templateregistry.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QImage>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/imgproc.hpp>
+
+TemplateRegistry::TemplateRegistry(LogFn log)
+    : m_log(std::move(log))
+{
+}
+
+std::vector<double> TemplateRegistry::scaleSteps(double maxScale, double minScale, double step)
+{
+    std::vector<double> out;
+    if (step <= 0.0 || maxScale < minScale) {
+        out.push_back(maxScale);
+        return out;
+    }
+    // 按下标计算，避免累减产生的浮点漂移丢掉最后一个尺度
+    const int n = (int)std::floor((maxScale - minScale) / step + 1e-6);
+    out.reserve(n + 1);
+    for (int i = 0; i <= n; ++i) out.push_back(maxScale - i * step);
+    return out;
+}
+
+int TemplateRegistry::buildCount() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_buildCount;
+}
+
+QString TemplateRegistry::locate(const QString &name) const
+{
+    // 优先从资源加载，其次从可执行目录的 assets
+    const QString res = QString(":/assets/%1.png").arg(name);
+    if (QFileInfo::exists(res)) return res;
+    const QString path = QCoreApplication::applicationDirPath() + QString("/assets/%1.png").arg(name);
+    if (QFileInfo::exists(path)) return path;
+    return QString();
+}
+
+TemplateRegistry::PyramidPtr TemplateRegistry::get(const QString &name, const std::vector<double> &scales)
+{
+    const QString path = locate(name);
+    if (path.isEmpty()) {
+        log(QString("模板图片仍未找到: :/assets/%1.png 或 程序目录/assets/%1.png").arg(name), LogLevel::Warning);
+        return PyramidPtr();
+    }
+    // 资源文件编译进程序不会变化，只有磁盘文件需要检查修改时间
+    const bool onDisk = !path.startsWith(':');
+    QDateTime mtime;
+    qint64 fileSize = -1;
+    if (onDisk) {
+        QFileInfo fi(path);
+        mtime = fi.lastModified();
+        fileSize = fi.size();
+    }
+
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.constFind(name);
+    if (it != m_entries.cend() && it->pyramid
+            && it->sourcePath == path && it->mtime == mtime && it->fileSize == fileSize
+            && it->pyramid->scales == scales) {
+        return it->pyramid;
+    }
+
+    PyramidPtr pyr = build(name, path, scales);
+    if (!pyr) return PyramidPtr();
+    Entry e;
+    e.pyramid = pyr;
+    e.sourcePath = path;
+    e.mtime = mtime;
+    e.fileSize = fileSize;
+    m_entries.insert(name, e);
+    m_buildCount++;
+    return pyr;
+}
+
+TemplateRegistry::PyramidPtr TemplateRegistry::build(const QString &name, const QString &path, const std::vector<double> &scales) const
+{
+    QImage img(path);
+    if (img.isNull()) {
+        log(QString("模板图片加载失败: %1").arg(path), LogLevel::Warning);
+        return PyramidPtr();
+    }
+    QImage rgba = img.convertToFormat(QImage::Format_RGBA8888);
+    cv::Mat templRGBA(rgba.height(), rgba.width(), CV_8UC4,
+                      const_cast<uchar*>(rgba.constBits()), rgba.bytesPerLine());
+
+    // 分离 alpha 作为掩膜
+    cv::Mat templ3, alpha;
+    cv::cvtColor(templRGBA, templ3, cv::COLOR_RGBA2BGR);
+    cv::extractChannel(templRGBA, alpha, 3);
+
+    // 先计算每个尺度的尺寸（与 cv::resize(fx, fy) 的取整一致），再一次性分配存储
+    std::vector<std::pair<double, cv::Size>> plan;
+    int totalRows = 0, maxCols = 0;
+    for (double scale : scales) {
+        cv::Size sz(cvRound(templ3.cols * scale), cvRound(templ3.rows * scale));
+        if (sz.width <= 1 || sz.height <= 1) continue;
+        plan.emplace_back(scale, sz);
+        totalRows += sz.height;
+        maxCols = std::max(maxCols, sz.width);
+    }
+
+    auto pyr = std::make_shared<Pyramid>();
+    pyr->name = name;
+    pyr->sourcePath = path;
+    pyr->size = QSize(templ3.cols, templ3.rows);
+    pyr->scales = scales;
+    if (plan.empty()) return pyr;
+
+    pyr->bgrStore.create(totalRows, maxCols, CV_8UC3);
+    pyr->maskStore.create(totalRows, maxCols, CV_8UC1);
+    pyr->levels.reserve(plan.size());
+
+    int row = 0;
+    for (const auto &p : plan) {
+        const cv::Size &sz = p.second;
+        const cv::Rect roi(0, row, sz.width, sz.height);
+        Level lv;
+        lv.scale = p.first;
+        lv.bgr = pyr->bgrStore(roi);
+        lv.mask = pyr->maskStore(roi);
+        // 目标为尺寸匹配的 ROI 时 resize/threshold 直接写入预分配存储
+        cv::resize(templ3, lv.bgr, sz, 0, 0, cv::INTER_AREA);
+        cv::Mat alphaScaled;
+        cv::resize(alpha, alphaScaled, sz, 0, 0, cv::INTER_AREA);
+        cv::threshold(alphaScaled, lv.mask, 10, 255, cv::THRESH_BINARY);
+        pyr->levels.push_back(lv);
+        row += sz.height;
+    }
+
+    log(QString("模板[%1]金字塔已构建: 源=%2 尺寸%3x%4 尺度数=%5")
+        .arg(name, path).arg(templ3.cols).arg(templ3.rows).arg((int)pyr->levels.size()));
+    return pyr;
+}
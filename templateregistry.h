@@ -0,0 +1,74 @@
+#ifndef TEMPLATEREGISTRY_H
+#define TEMPLATEREGISTRY_H
+
+#include <QString>
+#include <QStringList>
+#include <QSize>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "logsink.h"
+
+// 模板注册表
+// 每个模板只在首次使用或资源文件变化时构建一次多尺度金字塔（BGR + 二值掩膜），
+// 各尺度数据存放在预分配的连续 Mat 中，后续匹配直接复用。
+class TemplateRegistry
+{
+public:
+    using LogFn = ::LogFn;
+
+    struct Level {
+        double scale = 1.0;
+        cv::Mat bgr;    // CV_8UC3，bgrStore 的 ROI 视图
+        cv::Mat mask;   // CV_8UC1，maskStore 的 ROI 视图
+    };
+
+    struct Pyramid {
+        QString name;
+        QString sourcePath;
+        QSize size;                 // 原始模板尺寸
+        std::vector<double> scales; // 构建时请求的尺度序列
+        std::vector<Level> levels;  // 已剔除过小的尺度
+        cv::Mat bgrStore;
+        cv::Mat maskStore;
+    };
+    using PyramidPtr = std::shared_ptr<const Pyramid>;
+
+    explicit TemplateRegistry(LogFn log = LogFn());
+
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+
+    // 获取模板金字塔：优先资源 :/assets/<name>.png，其次程序目录 assets/<name>.png
+    // 文件未变化且尺度相同时直接返回缓存；找不到模板返回空指针
+    PyramidPtr get(const QString &name, const std::vector<double> &scales);
+
+    // 由最大尺度按步长递减到最小尺度（含端点，容忍浮点误差）
+    static std::vector<double> scaleSteps(double maxScale, double minScale, double step);
+
+    int buildCount() const;
+
+private:
+    struct Entry {
+        PyramidPtr pyramid;
+        QString sourcePath;
+        QDateTime mtime;
+        qint64 fileSize = -1;
+    };
+
+    QString locate(const QString &name) const;
+    PyramidPtr build(const QString &name, const QString &path, const std::vector<double> &scales) const;
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    mutable QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    int m_buildCount = 0;
+    LogFn m_log;
+};
+
+#endif // TEMPLATEREGISTRY_H
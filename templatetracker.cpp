@@ -0,0 +1,76 @@
+#include "templatetracker.h"
+
+#include <QMutexLocker>
+
+TemplateTracker::TemplateTracker(Detector &detector, const Params &params)
+    : m_detector(detector), m_params(params)
+{
+}
+
+void TemplateTracker::setParams(const Params &params)
+{
+    QMutexLocker lock(&m_mutex);
+    m_params = params;
+}
+
+void TemplateTracker::reset()
+{
+    QMutexLocker lock(&m_mutex);
+    m_hasTarget = false;
+    m_lostTarget = false;
+}
+
+TemplateResult TemplateTracker::process(const Frame &frame, TemplateMatcher::Mode fullMode, bool *trackedOut,
+                                       const Detector::CancelFn &cancel)
+{
+    // 同一时刻只跟踪一帧，状态按帧顺序推进
+    QMutexLocker lock(&m_mutex);
+    if (trackedOut) *trackedOut = false;
+    m_stats.frames++;
+    if (frame.size() != m_frameSize) {
+        m_frameSize = frame.size();
+        m_hasTarget = false;
+    }
+
+    if (m_hasTarget) {
+        const QRect last(m_last.pt, m_last.size);
+        const int padX = qMax(m_params.margin, int(last.width() * m_params.marginRatio));
+        const int padY = qMax(m_params.margin, int(last.height() * m_params.marginRatio));
+        const QRect window = last.adjusted(-padX, -padY, padX, padY);
+        const TemplateResult r = m_detector.runTemplateMatchNear(frame, window, m_last.scale, m_params.levelRadius);
+        if (r.pt.x() >= 0 && r.score >= m_params.minScore) {
+            m_stats.tracked++;
+            m_last = r;
+            if (trackedOut) *trackedOut = true;
+            return r;
+        }
+        m_stats.lost++;
+        m_lostTarget = true;
+    }
+
+    TemplateResult r{QPoint(-1, -1), 0.0, QSize()};
+    r.pt = m_detector.runTemplateMatch(frame, r.score, fullMode, &r.size, &r.scale, cancel, &r.cancelled);
+    if (r.cancelled) return r;
+    m_stats.fullSearches++;
+    m_hasTarget = r.pt.x() >= 0 && r.score >= m_params.minScore && !r.size.isEmpty();
+    if (m_hasTarget) {
+        if (m_lostTarget) m_stats.reacquired++;
+        m_lostTarget = false;
+        m_last = r;
+    }
+    return r;
+}
+
+TemplateTracker::Stats TemplateTracker::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+QString TemplateTracker::statsSummary() const
+{
+    const Stats s = stats();
+    return QString("模板跟踪: 帧=%1 窗口命中=%2 跟丢=%3 全图搜索=%4 重新捕获=%5 重捕获率=%6%")
+        .arg(s.frames).arg(s.tracked).arg(s.lost).arg(s.fullSearches).arg(s.reacquired)
+        .arg(100.0 * s.reacquisitionRate(), 0, 'f', 1);
+}
@@ -0,0 +1,57 @@
+#ifndef TEMPLATETRACKER_H
+#define TEMPLATETRACKER_H
+
+#include <QMutex>
+#include <QString>
+
+#include "detector.h"
+
+// 模板跟踪：连续帧中目标几乎总在上一帧的位置与尺度附近。
+// 命中后下一帧只在上次位置外扩的窗口内、上次尺度 ±1 档匹配；得分低于阈值（跟丢）时
+// 回退到完整的多尺度搜索重新捕获。每帧的匹配代价由整幅截图降为一个小窗口。
+class TemplateTracker
+{
+public:
+    struct Params {
+        double minScore = 0.8;      // 跟踪结果低于该得分视为跟丢
+        int margin = 32;            // 窗口每边至少外扩的像素
+        double marginRatio = 0.5;   // 以及按目标宽高的比例外扩
+        int levelRadius = 1;        // 上次尺度前后各几档
+    };
+
+    struct Stats {
+        qint64 frames = 0;
+        qint64 tracked = 0;         // 窗口内命中
+        qint64 lost = 0;            // 窗口内得分不足，回退全图
+        qint64 fullSearches = 0;    // 全图搜索次数（含首帧与跟丢后）
+        qint64 reacquired = 0;      // 跟丢后由全图搜索重新找到
+        // 跟踪尝试中需要重新捕获的比例
+        double reacquisitionRate() const { return tracked + lost > 0 ? double(lost) / (tracked + lost) : 0.0; }
+    };
+
+    explicit TemplateTracker(Detector &detector, const Params &params = Params());
+
+    void setParams(const Params &params);
+    // 丢弃跟踪状态，下一帧全图搜索
+    void reset();
+
+    // fullMode 为回退时使用的完整搜索模式；trackedOut 表示本帧由窗口跟踪得到。
+    // cancel 只作用于全图搜索（窗口匹配很快）；取消时结果带 cancelled，跟踪状态不变
+    TemplateResult process(const Frame &frame, TemplateMatcher::Mode fullMode, bool *trackedOut = nullptr,
+                           const Detector::CancelFn &cancel = Detector::CancelFn());
+
+    Stats stats() const;
+    QString statsSummary() const;
+
+private:
+    Detector &m_detector;
+    mutable QMutex m_mutex;
+    Params m_params;
+    bool m_hasTarget = false;
+    bool m_lostTarget = false;
+    TemplateResult m_last{QPoint(-1, -1), 0.0, QSize()};
+    QSize m_frameSize;
+    Stats m_stats;
+};
+
+#endif // TEMPLATETRACKER_H
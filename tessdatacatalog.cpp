@@ -0,0 +1,153 @@
+#include "tessdatacatalog.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent>
+
+TessdataCatalog::TessdataCatalog() = default;
+
+TessdataCatalog::~TessdataCatalog()
+{
+    m_stopping = true;
+    m_watcher.reset();
+    for (QFuture<void> &f : m_hashJobs) f.waitForFinished();
+}
+
+QStringList TessdataCatalog::defaultSearchPaths()
+{
+    const QString appDir = QCoreApplication::applicationDirPath();
+    QStringList candidates;
+    candidates << qEnvironmentVariable("TESSDATA_PREFIX");
+    candidates << QDir(appDir).filePath("tessdata");
+    candidates << QDir(appDir).filePath("../tessdata");
+    candidates << QDir(appDir).filePath("../../tessdata");
+    candidates << QDir(appDir).filePath("share/tessdata");
+    candidates << QDir(appDir).filePath("share/tesseract/tessdata");
+    // vcpkg 默认安装位置（构建目录旁）
+    candidates << QDir(appDir).filePath("../default/vcpkg_installed/x64-windows/share/tesseract/tessdata");
+    // 常见系统环境变量
+    const QString vcpkgRoot = qEnvironmentVariable("VCPKG_ROOT");
+    if (!vcpkgRoot.isEmpty()) candidates << QDir(vcpkgRoot).filePath("installed/x64-windows/share/tesseract/tessdata");
+    candidates.removeAll(QString());
+    return candidates;
+}
+
+void TessdataCatalog::scan(const QStringList &dirs)
+{
+    QElapsedTimer timer; timer.start();
+    QHash<QString, Entry> byName;
+    QStringList existing;
+    for (const QString &d : dirs) {
+        const QDir dir(d);
+        if (d.isEmpty() || !dir.exists()) continue;
+        existing << dir.absolutePath();
+        const QFileInfoList files = dir.entryInfoList(QStringList() << "*.traineddata", QDir::Files, QDir::Name);
+        for (const QFileInfo &fi : files) {
+            const QString name = fi.completeBaseName();
+            if (byName.contains(name)) continue;
+            Entry e;
+            e.name = name;
+            e.path = fi.absoluteFilePath();
+            e.size = fi.size();
+            e.modified = fi.lastModified();
+            byName.insert(name, e);
+        }
+    }
+
+    quint64 generation;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_dirs = dirs;
+        m_byName = byName;
+        generation = ++m_generation;
+    }
+    log(QString("[OCR模型] 扫描 %1 个目录（存在 %2 个），找到 %3 个模型，耗时 %4 ms")
+        .arg(dirs.size()).arg(existing.size()).arg(byName.size()).arg(timer.nsecsElapsed() / 1e6, 0, 'f', 1));
+    if (byName.isEmpty())
+        log("未检测到任何 .traineddata，请将其放在程序目录tessdata/或设置TESSDATA_PREFIX", LogLevel::Warning);
+
+    // 监视需要 Qt 事件循环，仅在应用对象所在线程创建
+    if (QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread()) {
+        if (!m_watcher) {
+            m_watcher.reset(new QFileSystemWatcher());
+            QObject::connect(m_watcher.get(), &QFileSystemWatcher::directoryChanged, [this](const QString &) { rescan(); });
+            QObject::connect(m_watcher.get(), &QFileSystemWatcher::fileChanged, [this](const QString &) { rescan(); });
+        }
+        const QStringList watched = m_watcher->directories() + m_watcher->files();
+        if (!watched.isEmpty()) m_watcher->removePaths(watched);
+        QStringList paths = existing;
+        for (const Entry &e : byName) paths << e.path;
+        if (!paths.isEmpty()) m_watcher->addPaths(paths);
+    }
+
+    hashInBackground(byName.values(), generation);
+}
+
+void TessdataCatalog::rescan()
+{
+    log("[OCR模型] tessdata 目录有变化，重新扫描");
+    scan(searchPaths());
+}
+
+void TessdataCatalog::hashInBackground(const QList<Entry> &entries, quint64 generation)
+{
+    // 清理已结束的任务，避免列表无限增长
+    for (int i = m_hashJobs.size() - 1; i >= 0; --i) {
+        if (m_hashJobs[i].isFinished()) m_hashJobs.removeAt(i);
+    }
+    m_hashJobs << QtConcurrent::run([this, entries, generation]() {
+        for (const Entry &e : entries) {
+            if (m_stopping) return;
+            QFile f(e.path);
+            if (!f.open(QIODevice::ReadOnly)) continue;
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+            if (!hash.addData(&f)) continue;
+            QMutexLocker lock(&m_mutex);
+            // 期间已重新扫描则丢弃
+            if (generation != m_generation) return;
+            auto it = m_byName.find(e.name);
+            if (it != m_byName.end() && it->path == e.path) it->sha1 = hash.result();
+        }
+    });
+}
+
+bool TessdataCatalog::lookup(const QString &langCode, Entry *out) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_byName.constFind(langCode);
+    if (it == m_byName.constEnd() && langCode.startsWith("chi_sim"))
+        it = m_byName.constFind(QStringLiteral("chi_sim"));
+    if (it == m_byName.constEnd()) return false;
+    if (out) *out = it.value();
+    return true;
+}
+
+QList<TessdataCatalog::Entry> TessdataCatalog::entries() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_byName.values();
+}
+
+QStringList TessdataCatalog::searchPaths() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_dirs;
+}
+
+QString TessdataCatalog::summary() const
+{
+    QStringList parts;
+    for (const Entry &e : entries()) {
+        parts << QString("%1 %2MB sha1=%3 (%4)").arg(e.name).arg(e.size / 1048576.0, 0, 'f', 1)
+                     .arg(e.sha1.isEmpty() ? QString("计算中") : QString::fromLatin1(e.sha1.toHex().left(12)))
+                     .arg(e.path);
+    }
+    return parts.join("; ");
+}
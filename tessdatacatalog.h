@@ -0,0 +1,66 @@
+#ifndef TESSDATACATALOG_H
+#define TESSDATACATALOG_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+#include "logsink.h"
+
+class QFileSystemWatcher;
+
+// tessdata 模型目录
+// 启动时扫描一次候选目录，记录每个 .traineddata 的语言名、大小、修改时间与哈希；
+// 识别时按语言变体查表，不再访问文件系统。目录或模型文件变化时（需事件循环）自动重新扫描。
+class TessdataCatalog
+{
+public:
+    using LogFn = ::LogFn;
+
+    struct Entry {
+        QString name;           // 文件名去掉 .traineddata，如 chi_sim_fast
+        QString path;
+        qint64 size = 0;
+        QDateTime modified;
+        QByteArray sha1;        // 后台计算，完成前为空
+    };
+
+    TessdataCatalog();
+    ~TessdataCatalog();
+
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+
+    // 按顺序排列的候选目录：TESSDATA_PREFIX、程序目录附近、vcpkg 安装目录
+    static QStringList defaultSearchPaths();
+    // 扫描目录（同名模型以先出现的目录为准）并开始监视
+    void scan(const QStringList &dirs = defaultSearchPaths());
+
+    // langCode 对应的模型：优先同名变体，chi_sim_* 缺失时回退标准 chi_sim
+    bool lookup(const QString &langCode, Entry *out) const;
+    QList<Entry> entries() const;
+    QStringList searchPaths() const;
+    QString summary() const;
+
+private:
+    void rescan();
+    void hashInBackground(const QList<Entry> &entries, quint64 generation);
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    mutable QMutex m_mutex;
+    QStringList m_dirs;
+    QHash<QString, Entry> m_byName;
+    quint64 m_generation = 0;
+    std::unique_ptr<QFileSystemWatcher> m_watcher;
+    QList<QFuture<void>> m_hashJobs;
+    std::atomic<bool> m_stopping{false};
+    LogFn m_log;
+};
+
+#endif // TESSDATACATALOG_H
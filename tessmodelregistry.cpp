@@ -0,0 +1,43 @@
+#include "tessmodelregistry.h"
+
+#include <QMutexLocker>
+
+TessModel::~TessModel()
+{
+    if (m_data) m_file.unmap(m_data);
+}
+
+TessModelPtr TessModelRegistry::get(const QString &path, qint64 size, const QDateTime &modified)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_models.constFind(path);
+    if (it != m_models.constEnd()) {
+        const TessModelPtr &m = it.value();
+        if (m->size() == size && m->m_modified == modified) return m;
+        log(QString("[OCR模型] 文件已变化，重新映射: %1").arg(path));
+    }
+
+    auto model = std::make_shared<TessModel>();
+    model->m_path = path;
+    model->m_file.setFileName(path);
+    if (!model->m_file.open(QIODevice::ReadOnly)) {
+        log(QString("[OCR模型] 无法打开: %1 (%2)").arg(path, model->m_file.errorString()), LogLevel::Warning);
+        return TessModelPtr();
+    }
+    model->m_size = model->m_file.size();
+    model->m_data = model->m_size > 0 ? model->m_file.map(0, model->m_size) : nullptr;
+    if (!model->m_data) {
+        log(QString("[OCR模型] 映射失败: %1 (%2)").arg(path, model->m_file.errorString()), LogLevel::Warning);
+        return TessModelPtr();
+    }
+    model->m_modified = modified;
+    log(QString("[OCR模型] 已映射 %1 (%2 MB)").arg(path).arg(model->m_size / 1048576.0, 0, 'f', 1));
+    m_models.insert(path, model);
+    return model;
+}
+
+void TessModelRegistry::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_models.clear();
+}
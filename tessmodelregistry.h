@@ -0,0 +1,56 @@
+#ifndef TESSMODELREGISTRY_H
+#define TESSMODELREGISTRY_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <memory>
+
+#include "logsink.h"
+
+// 一个已映射到内存的 traineddata 文件，只读，可被多个引擎同时使用
+class TessModel
+{
+public:
+    ~TessModel();
+
+    const QString &path() const { return m_path; }
+    const char *data() const { return reinterpret_cast<const char *>(m_data); }
+    qint64 size() const { return m_size; }
+
+private:
+    friend class TessModelRegistry;
+    QFile m_file;
+    QString m_path;
+    uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    QDateTime m_modified;
+};
+using TessModelPtr = std::shared_ptr<const TessModel>;
+
+// traineddata 映射注册表
+// 每个文件只 map 一次，引擎 Init 直接使用内存中的模型数据：
+// 变体文件（chi_sim_fast 等）无需再复制为临时目录下的 chi_sim.traineddata，也不修改 TESSDATA_PREFIX。
+// 文件大小或修改时间变化时重新映射，仍在使用旧映射的调用方不受影响。
+class TessModelRegistry
+{
+public:
+    using LogFn = ::LogFn;
+
+    void setLogger(LogFn fn) { m_log = std::move(fn); }
+
+    // 返回 path 的映射，失败返回空；size / modified 来自模型目录，与缓存不一致时重新映射
+    TessModelPtr get(const QString &path, qint64 size, const QDateTime &modified);
+    void clear();
+
+private:
+    void log(const QString &msg, LogLevel level = LogLevel::Info) const { if (m_log) m_log(level, msg); }
+
+    QMutex m_mutex;
+    QHash<QString, TessModelPtr> m_models;
+    LogFn m_log;
+};
+
+#endif // TESSMODELREGISTRY_H
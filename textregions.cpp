@@ -0,0 +1,51 @@
+#include "textregions.h"
+
+#include <algorithm>
+#include <vector>
+#include <opencv2/imgproc.hpp>
+
+#include "geometry.h"
+#include "stagemetrics.h"
+
+QVector<QRect> TextRegionDetector::detect(const Frame &frame, const QRect &roi) const
+{
+    StageTimer stage(Stage::TextDetect);
+    QVector<QRect> rects;
+    const QRect area = roi.isValid() ? roi.intersected(frame.rect()) : frame.rect();
+    if (frame.isNull() || area.isEmpty()) return rects;
+
+    // 复用帧的灰度平面，随后的行识别也从同一平面裁剪
+    const cv::Mat gray = frame.gray()(cv::Rect(area.x(), area.y(), area.width(), area.height()));
+    cv::Mat grad, bw, joined;
+    cv::morphologyEx(gray, grad, cv::MORPH_GRADIENT, cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3)));
+    cv::threshold(grad, bw, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    cv::morphologyEx(bw, joined, cv::MORPH_CLOSE,
+                     cv::getStructuringElement(cv::MORPH_RECT, cv::Size(qMax(1, m_opt.closeWidth), 1)));
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(joined, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    for (const auto &c : contours) {
+        const cv::Rect r = cv::boundingRect(c);
+        if (r.height < m_opt.minHeight || r.height > m_opt.maxHeight || r.width < m_opt.minWidth) continue;
+        if (r.width < r.height * m_opt.minAspect) continue;
+        const double fill = double(cv::countNonZero(bw(r))) / r.area();
+        if (fill < m_opt.minFill || fill > m_opt.maxFill) continue;
+        // 外扩少许，避免裁掉笔画边缘
+        const int pad = qMax(2, r.height / 4);
+        rects << QRect(r.x + area.x(), r.y + area.y(), r.width, r.height).adjusted(-pad, -pad, pad, pad).intersected(area);
+    }
+
+    // 只合并同一行被字距断开的块：纵向大部分重叠才合并，上下相邻的行保持分开，
+    // 否则多行块按 PSM_SINGLE_LINE 识别会得到乱码
+    mergeIntersectingRects(rects, m_opt.minRowOverlap);
+    // 合并后再按行高筛一次（外扩后的高度），仍超出的不是单行
+    const int maxPadded = m_opt.maxHeight + 2 * qMax(2, m_opt.maxHeight / 4);
+    rects.erase(std::remove_if(rects.begin(), rects.end(),
+                               [maxPadded](const QRect &r) { return r.height() > maxPadded; }),
+                rects.end());
+    // 大块先识别，并行时尾部更均匀
+    std::sort(rects.begin(), rects.end(), [](const QRect &a, const QRect &b) {
+        return qint64(a.width()) * a.height() > qint64(b.width()) * b.height();
+    });
+    return rects;
+}
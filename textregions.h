@@ -0,0 +1,39 @@
+#ifndef TEXTREGIONS_H
+#define TEXTREGIONS_H
+
+#include <QRect>
+#include <QVector>
+
+#include "frame.h"
+
+// 候选文本行检测
+// 灰度形态学梯度突出笔画边缘，Otsu 二值化后用横向闭运算把同一行的字连成块，
+// 再按高度、宽高比与填充率筛掉游戏美术中的大块纹理，得到适合单行识别的矩形。
+class TextRegionDetector
+{
+public:
+    struct Options {
+        int minHeight = 10;         // 行高范围（像素）
+        int maxHeight = 80;
+        int minWidth = 16;
+        double minAspect = 1.0;     // 宽 / 高
+        double minFill = 0.15;      // 块内梯度像素占比
+        double maxFill = 0.90;
+        int closeWidth = 9;         // 横向闭运算核宽，约一个字距
+        double minRowOverlap = 0.6; // 外扩后的块纵向重叠达到较矮者高度的该比例才视为同一行并合并
+    };
+
+    TextRegionDetector() = default;
+    explicit TextRegionDetector(const Options &options) : m_opt(options) {}
+
+    void setOptions(const Options &options) { m_opt = options; }
+    const Options &options() const { return m_opt; }
+
+    // roi 有效时只在该区域内检测，返回全图坐标，已外扩少许并按面积从大到小排序
+    QVector<QRect> detect(const Frame &frame, const QRect &roi = QRect()) const;
+
+private:
+    Options m_opt;
+};
+
+#endif // TEXTREGIONS_H
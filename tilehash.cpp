@@ -0,0 +1,57 @@
+#include "tilehash.h"
+
+TileHasher::TileHasher(int downscale, int tilePx, int quantShift)
+    : m_downscale(qMax(1, downscale)), m_tilePx(qMax(1, tilePx)), m_quantShift(qBound(0, quantShift, 7))
+{
+}
+
+TileHasher::Grid TileHasher::compute(const Frame &frame) const
+{
+    Grid g;
+    if (frame.isNull()) return g;
+    g.frameSize = frame.size();
+
+    // 先缩小再转灰度，只处理 1/(downscale^2) 的像素
+    const cv::Mat gray = frame.graySmall(m_downscale);
+
+    g.cols = (gray.cols + m_tilePx - 1) / m_tilePx;
+    g.rows = (gray.rows + m_tilePx - 1) / m_tilePx;
+    g.hashes.fill(1469598103934665603ULL, g.cols * g.rows);   // FNV-1a 初值
+
+    const quint64 prime = 1099511628211ULL;
+    for (int y = 0; y < gray.rows; ++y) {
+        const uchar *line = gray.ptr<uchar>(y);
+        quint64 *rowHashes = g.hashes.data() + (y / m_tilePx) * g.cols;
+        for (int x = 0; x < gray.cols; ++x) {
+            quint64 &h = rowHashes[x / m_tilePx];
+            h ^= quint64(line[x] >> m_quantShift);
+            h *= prime;
+        }
+    }
+    return g;
+}
+
+TileHasher::Diff TileHasher::diff(const Grid &prev, const Grid &cur)
+{
+    Diff d;
+    d.total = cur.hashes.size();
+    d.dirty.fill(true, d.total);
+    if (prev.cols != cur.cols || prev.rows != cur.rows || prev.frameSize != cur.frameSize) {
+        d.changed = d.total;
+        return d;
+    }
+    for (int i = 0; i < d.total; ++i) {
+        d.dirty[i] = prev.hashes[i] != cur.hashes[i];
+        if (d.dirty[i]) d.changed++;
+    }
+    return d;
+}
+
+QRect TileHasher::tileRect(const Grid &grid, int index) const
+{
+    if (grid.cols <= 0 || index < 0 || index >= grid.hashes.size()) return QRect();
+    const int side = m_tilePx * m_downscale;
+    const int tx = index % grid.cols;
+    const int ty = index / grid.cols;
+    return QRect(tx * side, ty * side, side, side).intersected(QRect(QPoint(0, 0), grid.frameSize));
+}
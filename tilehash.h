@@ -0,0 +1,51 @@
+#ifndef TILEHASH_H
+#define TILEHASH_H
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+#include "frame.h"
+
+// 帧变化检测
+// 将帧缩小为灰度图后切成网格，逐格计算量化后的 64 位哈希，与上一帧比较得出变化的格子。
+// 量化会吃掉轻微的压缩噪声与抖动，整个过程只读取缩小后的图像，代价远小于一次识别。
+class TileHasher
+{
+public:
+    struct Grid {
+        int cols = 0;
+        int rows = 0;
+        QSize frameSize;
+        QVector<quint64> hashes;    // 行优先，cols * rows 个
+        bool isEmpty() const { return hashes.isEmpty(); }
+    };
+
+    struct Diff {
+        int changed = 0;
+        int total = 0;
+        QVector<bool> dirty;        // 与 Grid::hashes 一一对应
+        bool any() const { return changed > 0; }
+        double ratio() const { return total > 0 ? double(changed) / total : 1.0; }
+    };
+
+    // downscale：缩小倍数；tilePx：缩小后每格边长；quantShift：灰度量化右移位数
+    explicit TileHasher(int downscale = 8, int tilePx = 8, int quantShift = 3);
+
+    // 缩小灰度图取自帧的共享平面，同一帧多次计算不重复缩放
+    Grid compute(const Frame &frame) const;
+    // 网格尺寸不同（分辨率变化）时视为全部变化
+    static Diff diff(const Grid &prev, const Grid &cur);
+    // 格子在原始帧中的像素区域
+    QRect tileRect(const Grid &grid, int index) const;
+
+    int downscale() const { return m_downscale; }
+    int tilePx() const { return m_tilePx; }
+
+private:
+    int m_downscale;
+    int m_tilePx;
+    int m_quantShift;
+};
+
+#endif // TILEHASH_H